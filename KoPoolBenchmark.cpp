@@ -0,0 +1,1334 @@
+#include <array>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <memory_resource>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "unordered_dense.h"
+#include "KoPoolIteratable.h"
+
+// Benchmark of 'KoPoolIteratable' against 'std::vector', 'ankerl::unordered_dense' and 'std::pmr' pools.
+// Each operation is timed by batches of 'batchSize' calls, so the clock overhead is amortized, and the per operation
+// time of each batch is a sample. The samples of all repetitions are reduced to p50/p99/p999.
+// Hardware counters are read by 'perf_event_open' on Linux and reported per operation when available.
+// '--footprint' reports memory instead of time: bytes requested vs bytes held and the resident set size per phase.
+// '--small-pools' times the iteration of many pools of 'SMALL_POOL_SIZE' elements by 'Opt::initialSubPoolSize'.
+// Usage: KoPoolBenchmark [--count N] [--reps N] [--warmup N] [--batch N] [--json path] [--no-counters] [--footprint]
+//                        [--small-pools]
+
+#define BenchAssert(expression) \
+do { \
+    if (!(expression)) { \
+        fprintf(stderr, "BenchAssert failed: %s (%s:%d)\n", #expression, __FILE__, __LINE__); \
+        std::abort(); \
+    } \
+} while (0)
+
+// Prevents the compiler from removing the iteration loops
+template <typename T>
+static void DoNotOptimize(const T& value) {
+
+#if defined(_MSC_VER)
+    static volatile T sink{};
+    sink = value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Per thread user space hardware counters. Each counter is opened separately, so a counter which is unsupported by
+// the CPU, the VM or 'perf_event_paranoid' is just unavailable. On other platforms all counters are unavailable
+class PerfCounters {
+public:
+
+    enum Counter : size_t {
+
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        DTLBMisses,
+        BranchMisses,
+
+        COUNT
+    };
+
+    static constexpr const char* COUNTER_TO_STR[] = { "instructions", "l1dMisses", "llcMisses", "dtlbMisses", "branchMisses" };
+
+    using Values = std::array<double, Counter::COUNT>;
+
+    PerfCounters(const bool isEnabled) {
+
+        _fds.fill(-1);
+
+#if defined(__linux__)
+        if (!isEnabled) {
+            return;
+        }
+
+        const auto hwCache = [](const uint64_t cache, const uint64_t op, const uint64_t result) {
+            return cache | (op << 8) | (result << 16);
+        };
+
+        Open(Counter::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        Open(
+            Counter::L1DMisses, PERF_TYPE_HW_CACHE,
+            hwCache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)
+        );
+        Open(Counter::LLCMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        Open(
+            Counter::DTLBMisses, PERF_TYPE_HW_CACHE,
+            hwCache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)
+        );
+        Open(Counter::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#else
+        (void)isEnabled;
+#endif
+    }
+
+    ~PerfCounters() {
+
+#if defined(__linux__)
+        for (const int fd : _fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool IsAvailable(const Counter counter) const noexcept {
+        return _fds[counter] >= 0;
+    }
+
+    bool IsAnyAvailable() const noexcept {
+
+        for (size_t i = 0; i < Counter::COUNT; ++i) {
+            if (IsAvailable(static_cast<Counter>(i))) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Counters run all the time, a section is the difference of two reads. Values are scaled by the enabled/running
+    // time, because the kernel multiplexes counters when there are more of them than hardware registers
+    Values Read() const noexcept {
+
+        Values values{};
+
+#if defined(__linux__)
+        for (size_t i = 0; i < Counter::COUNT; ++i) {
+
+            if (_fds[i] < 0) {
+                continue;
+            }
+
+            // value, time enabled, time running
+            uint64_t data[3]{};
+            if (read(_fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+                continue;
+            }
+
+            values[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+#endif
+
+        return values;
+    }
+
+private:
+
+#if defined(__linux__)
+    void Open(const Counter counter, const uint32_t type, const uint64_t config) {
+
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        _fds[counter] = fd >= 0 ? static_cast<int>(fd) : -1;
+    }
+#endif
+
+private:
+
+    std::array<int, Counter::COUNT> _fds{};
+};
+
+// Resident set size of the process, zeros on other platforms than Linux
+class ProcessMemory {
+public:
+
+    static size_t GetRSS() noexcept {
+
+#if defined(__linux__)
+        FILE* pFile = fopen("/proc/self/statm", "r");
+        if (!pFile) {
+            return 0;
+        }
+
+        unsigned long long numPages = 0;
+        unsigned long long numResidentPages = 0;
+        const int numRead = fscanf(pFile, "%llu %llu", &numPages, &numResidentPages);
+        fclose(pFile);
+
+        return numRead == 2 ? static_cast<size_t>(numResidentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+        return 0;
+#endif
+    }
+
+    // 'VmHWM' of '/proc/self/status'
+    static size_t GetPeakRSS() noexcept {
+
+#if defined(__linux__)
+        FILE* pFile = fopen("/proc/self/status", "r");
+        if (!pFile) {
+            return 0;
+        }
+
+        size_t peakInBytes = 0;
+
+        char line[256];
+        while (fgets(line, sizeof(line), pFile)) {
+
+            unsigned long long peakInKiB = 0;
+            if (sscanf(line, "VmHWM: %llu kB", &peakInKiB) == 1) {
+
+                peakInBytes = static_cast<size_t>(peakInKiB) * 1024;
+                break;
+            }
+        }
+
+        fclose(pFile);
+
+        return peakInBytes;
+#else
+        return 0;
+#endif
+    }
+
+    // Peak is reset to the current RSS, 'false' if the kernel doesn't support it, then the peak is process wide
+    static bool ResetPeakRSS() noexcept {
+
+#if defined(__linux__)
+        FILE* pFile = fopen("/proc/self/clear_refs", "w");
+        if (!pFile) {
+            return false;
+        }
+
+        const bool isOk = fputs("5", pFile) >= 0;
+        return fclose(pFile) == 0 && isOk;
+#else
+        return false;
+#endif
+    }
+
+    // Returns the freed heap memory to the OS, so the RSS of a run doesn't include the heap of the previous runs
+    static void TrimHeap() noexcept {
+
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+    }
+};
+
+class Bench {
+public:
+
+    struct Opt {
+
+        size_t count = 200'000;
+
+        // The count of big elements is limited, so each run touches at most this amount of element bytes
+        size_t maxBytes = 256 * 1024 * 1024;
+
+        size_t reps = 5;
+        size_t warmup = 1;
+        size_t batchSize = 1024;
+
+        std::string jsonPath;
+
+        bool isCountersEnabled = true;
+        bool isFootprint = false;
+
+        // 'count' elements split to pools of 'SMALL_POOL_SIZE' elements
+        bool isSmallPools = false;
+    };
+
+    enum class Pattern : size_t {
+
+        FIFO,
+        LIFO,
+        Random,
+
+        // Runs of 1..'BURST_LENGTH_MAX' neighbouring elements (in the allocation order) are deleted together
+        Bursty,
+
+        COUNT
+    };
+
+    enum Op : size_t {
+
+        Allocate,
+        Deallocate,
+        Iterate,
+
+        COUNT
+    };
+
+    static constexpr const char* PATTERN_TO_STR[] = { "FIFO", "LIFO", "Random", "Bursty" };
+    static constexpr const char* OP_TO_STR[] = { "Allocate", "Deallocate", "Iterate" };
+
+    static constexpr double FILLS[] = { 1.0, 0.5, 0.1 };
+    static constexpr size_t BURST_LENGTH_MAX = 64;
+
+    static constexpr size_t SMALL_POOL_SIZE = 1000;
+    static constexpr size_t SMALL_POOL_INITIAL_SIZES[] = { 2, 64, 1024, 4096 };
+
+    struct Result {
+
+        std::string container;
+        size_t elementSizeInBytes = 0;
+        Pattern pattern = Pattern::FIFO;
+        double fill = 1.0;
+        Op op = Op::Allocate;
+
+        size_t numSamples = 0;
+        double nsPerOpMean = 0.0;
+        double nsPerOpP50 = 0.0;
+        double nsPerOpP99 = 0.0;
+        double nsPerOpP999 = 0.0;
+
+        // Mean per operation, valid if the counter is available
+        PerfCounters::Values countersPerOp{};
+    };
+
+    // Bytes held by a container, the heap overhead of 'new' is unknown so heap elements are counted by 'sizeof(T)'
+    struct Footprint {
+
+        size_t dataSizeInBytes = 0;
+        size_t skipBitmapSizeInBytes = 0;
+        size_t metadataSizeInBytes = 0;
+    };
+
+    enum Phase : size_t {
+
+        Fill,
+        Delete,
+        Refill,
+        Drain,
+
+        PHASES_CNT
+    };
+
+    static constexpr const char* PHASE_TO_STR[] = { "Fill", "Delete", "Refill", "Drain" };
+
+    struct FootprintResult {
+
+        std::string container;
+        size_t elementSizeInBytes = 0;
+        Pattern pattern = Pattern::FIFO;
+        double fill = 1.0;
+        Phase phase = Phase::Fill;
+
+        size_t numAlive = 0;
+        size_t requestedSizeInBytes = 0;
+        Footprint footprint{};
+
+        // Relative to the RSS before the container is created
+        int64_t rssDelta = 0;
+        int64_t peakRSSDelta = 0;
+    };
+
+    // Samples of a single operation of a configuration: ns per operation of each batch and counters of all batches
+    struct OpSamples {
+
+        std::vector<double> nsPerOp;
+
+        PerfCounters::Values counters{};
+        size_t numOps = 0;
+    };
+
+    using Samples = std::array<OpSamples, Op::COUNT>;
+
+    Bench(const Opt& opt)
+        : _opt(opt)
+        , _counters(opt.isCountersEnabled)
+    {}
+
+    void Run() {
+
+        if (_opt.isFootprint) {
+
+            if (!ProcessMemory::ResetPeakRSS()) {
+                printf("Peak RSS can't be reset, it is the peak of the process\n");
+            }
+
+            RunFootprintElementSize<16>();
+            RunFootprintElementSize<64>();
+            RunFootprintElementSize<256>();
+            RunFootprintElementSize<1024>();
+            RunFootprintElementSize<4096>();
+
+            if (!_opt.jsonPath.empty()) {
+                WriteJson();
+            }
+
+            return;
+        }
+
+        if (_opt.isCountersEnabled && !_counters.IsAnyAvailable()) {
+            printf("Hardware counters are unavailable, only the time is reported\n");
+        }
+
+        if (_opt.isSmallPools) {
+
+            RunSmallPoolsElementSize<16>();
+            RunSmallPoolsElementSize<64>();
+            RunSmallPoolsElementSize<256>();
+
+            if (!_opt.jsonPath.empty()) {
+                WriteJson();
+            }
+
+            return;
+        }
+
+        RunElementSize<16>();
+        RunElementSize<64>();
+        RunElementSize<256>();
+        RunElementSize<1024>();
+        RunElementSize<4096>();
+
+        if (!_opt.jsonPath.empty()) {
+            WriteJson();
+        }
+    }
+
+private:
+
+    template <size_t SIZE_IN_BYTES>
+    struct Element {
+
+        size_t cnt = 1;
+        uint8_t payload[SIZE_IN_BYTES - sizeof(size_t)]{};
+    };
+
+    // Maps an allocation index to the element and its position in a dense array, so the dense containers
+    // can delete by swapping with the last element
+    template <typename Handle>
+    struct DenseIndex {
+
+        std::vector<Handle> handles;
+        std::vector<size_t> positions;
+        std::vector<size_t> owners;
+
+        void Reset(const size_t count) {
+
+            handles.clear();
+            owners.clear();
+            positions.assign(count, 0);
+        }
+
+        void Push(const size_t allocationID, const Handle& handle) {
+
+            positions[allocationID] = handles.size();
+            handles.push_back(handle);
+            owners.push_back(allocationID);
+        }
+
+        Handle Pop(const size_t allocationID) {
+
+            const size_t position = positions[allocationID];
+            const Handle handle = std::move(handles[position]);
+
+            handles[position] = std::move(handles.back());
+            owners[position] = owners.back();
+            positions[owners[position]] = position;
+
+            handles.pop_back();
+            owners.pop_back();
+
+            return handle;
+        }
+    };
+
+    // 'IS_SKIP_BITMAP_COLOCATED' - 'Opt::isSkipBitmapColocated', one block per sub pool
+    template <typename T, bool IS_SKIP_BITMAP_COLOCATED = false>
+    class KoPoolContainer {
+    public:
+
+        static constexpr const char* NAME = IS_SKIP_BITMAP_COLOCATED ? "KoPoolColocated" : "KoPool";
+
+        KoPoolContainer()
+            : _pool(MakeOpt())
+        {}
+
+        void Reset(const size_t count) {
+            _pointers.assign(count, nullptr);
+        }
+
+        void Allocate(const size_t allocationID) {
+            _pointers[allocationID] = _pool.Allocate<T>();
+        }
+
+        void Deallocate(const size_t allocationID) {
+            _pool.Deallocate(_pointers[allocationID]);
+        }
+
+        size_t Iterate() const {
+
+            size_t cnt = 0;
+            KoPoolIterator<T> iterator = _pool.GetIterator<T>();
+            while (const T* pData = iterator.Next()) {
+                cnt += pData->cnt;
+            }
+
+            return cnt;
+        }
+
+        Footprint GetFootprint() const {
+
+            const KoPoolIteratable::Stats stats = _pool.GetStats();
+
+            Footprint footprint{};
+            footprint.dataSizeInBytes = stats.dataSizeInBytes;
+            footprint.skipBitmapSizeInBytes = stats.skipBitmapSizeInBytes;
+            footprint.metadataSizeInBytes = stats.metadataSizeInBytes;
+
+            return footprint;
+        }
+
+    private:
+
+        static KoPoolIteratable::Opt MakeOpt() {
+
+            KoPoolIteratable::Opt opt{ sizeof(T), alignof(T) };
+            opt.isSkipBitmapColocated = IS_SKIP_BITMAP_COLOCATED;
+
+            return opt;
+        }
+
+        KoPoolIteratable _pool;
+
+        // Owned by the harness, like handles stored by the user
+        std::vector<T*> _pointers;
+    };
+
+    // The common pattern the pool replaces: heap allocated elements and a vector of pointers to iterate them
+    template <typename T>
+    class VectorOfPointersContainer {
+    public:
+
+        static constexpr const char* NAME = "STDVector<T*>";
+
+        void Reset(const size_t count) {
+            _index.Reset(count);
+        }
+
+        void Allocate(const size_t allocationID) {
+            _index.Push(allocationID, new T{});
+        }
+
+        void Deallocate(const size_t allocationID) {
+            delete _index.Pop(allocationID);
+        }
+
+        size_t Iterate() const {
+
+            size_t cnt = 0;
+            for (const T* pData : _index.handles) {
+                cnt += pData->cnt;
+            }
+
+            return cnt;
+        }
+
+        Footprint GetFootprint() const {
+
+            Footprint footprint{};
+            footprint.dataSizeInBytes = _index.handles.size() * sizeof(T);
+            footprint.metadataSizeInBytes = _index.handles.capacity() * sizeof(T*);
+
+            return footprint;
+        }
+
+    private:
+
+        DenseIndex<T*> _index;
+    };
+
+    // The iteration lower bound: dense values, but pointers are not stable
+    template <typename T>
+    class VectorOfValuesContainer {
+    public:
+
+        static constexpr const char* NAME = "STDVector<T>";
+
+        void Reset(const size_t count) {
+            _index.Reset(count);
+        }
+
+        void Allocate(const size_t allocationID) {
+            _index.Push(allocationID, T{});
+        }
+
+        void Deallocate(const size_t allocationID) {
+            _index.Pop(allocationID);
+        }
+
+        size_t Iterate() const {
+
+            size_t cnt = 0;
+            for (const T& data : _index.handles) {
+                cnt += data.cnt;
+            }
+
+            return cnt;
+        }
+
+    private:
+
+        DenseIndex<T> _index;
+    };
+
+    template <typename T>
+    class UnorderedSetContainer {
+    public:
+
+        static constexpr const char* NAME = "UnorderedSet";
+
+        void Reset(const size_t count) {
+            _pointers.assign(count, nullptr);
+        }
+
+        void Allocate(const size_t allocationID) {
+
+            T* pData = new T{};
+            _pointers[allocationID] = pData;
+            _set.insert(pData);
+        }
+
+        void Deallocate(const size_t allocationID) {
+
+            T* pData = _pointers[allocationID];
+            _set.erase(pData);
+            delete pData;
+        }
+
+        size_t Iterate() const {
+
+            size_t cnt = 0;
+            for (const T* pData : _set) {
+                cnt += pData->cnt;
+            }
+
+            return cnt;
+        }
+
+        Footprint GetFootprint() const {
+
+            using Set = ankerl::unordered_dense::set<T*>;
+
+            Footprint footprint{};
+            footprint.dataSizeInBytes = _set.size() * sizeof(T);
+            footprint.metadataSizeInBytes =
+                _set.values().capacity() * sizeof(T*) + _set.bucket_count() * sizeof(typename Set::bucket_type);
+
+            return footprint;
+        }
+
+    private:
+
+        ankerl::unordered_dense::set<T*> _set;
+        std::vector<T*> _pointers;
+    };
+
+    // 'std::pmr::unsynchronized_pool_resource' has no iteration, so a vector of pointers is maintained like for the heap
+    template <typename T>
+    class PmrPoolContainer {
+    public:
+
+        static constexpr const char* NAME = "PmrPool";
+
+        void Reset(const size_t count) {
+            _index.Reset(count);
+        }
+
+        void Allocate(const size_t allocationID) {
+
+            T* pData = reinterpret_cast<T*>(_resource.allocate(sizeof(T), alignof(T)));
+            new (pData) T{};
+
+            _index.Push(allocationID, pData);
+        }
+
+        void Deallocate(const size_t allocationID) {
+
+            T* pData = _index.Pop(allocationID);
+            pData->~T();
+
+            _resource.deallocate(pData, sizeof(T), alignof(T));
+        }
+
+        size_t Iterate() const {
+
+            size_t cnt = 0;
+            for (const T* pData : _index.handles) {
+                cnt += pData->cnt;
+            }
+
+            return cnt;
+        }
+
+    private:
+
+        std::pmr::unsynchronized_pool_resource _resource;
+        DenseIndex<T*> _index;
+    };
+
+    template <size_t SIZE_IN_BYTES>
+    void RunElementSize() {
+
+        using T = Element<SIZE_IN_BYTES>;
+        static_assert(sizeof(T) == SIZE_IN_BYTES, "");
+
+        const size_t count = std::max<size_t>(std::min(_opt.count, _opt.maxBytes / SIZE_IN_BYTES), 1);
+
+        printf("Element %zu bytes, %zu elements:\n", SIZE_IN_BYTES, count);
+
+        RunContainer<KoPoolContainer<T>>(SIZE_IN_BYTES, count);
+        RunContainer<KoPoolContainer<T, true>>(SIZE_IN_BYTES, count);
+        RunContainer<VectorOfPointersContainer<T>>(SIZE_IN_BYTES, count);
+        RunContainer<VectorOfValuesContainer<T>>(SIZE_IN_BYTES, count);
+        RunContainer<UnorderedSetContainer<T>>(SIZE_IN_BYTES, count);
+        RunContainer<PmrPoolContainer<T>>(SIZE_IN_BYTES, count);
+
+        printf("--------------------------\n");
+    }
+
+    template <size_t SIZE_IN_BYTES>
+    void RunFootprintElementSize() {
+
+        using T = Element<SIZE_IN_BYTES>;
+
+        const size_t count = std::max<size_t>(std::min(_opt.count, _opt.maxBytes / SIZE_IN_BYTES), 1);
+
+        printf("Element %zu bytes, %zu elements:\n", SIZE_IN_BYTES, count);
+
+        RunFootprint<KoPoolContainer<T>>(SIZE_IN_BYTES, count);
+        RunFootprint<KoPoolContainer<T, true>>(SIZE_IN_BYTES, count);
+        RunFootprint<VectorOfPointersContainer<T>>(SIZE_IN_BYTES, count);
+        RunFootprint<UnorderedSetContainer<T>>(SIZE_IN_BYTES, count);
+
+        printf("--------------------------\n");
+    }
+
+    // Allocates 'count' elements, deallocates them by 'pattern' until 'fill' of them are alive,
+    // allocates back to 'count' and deallocates all, the footprint is taken after each phase
+    template <typename Container>
+    void RunFootprint(const size_t elementSizeInBytes, const size_t count) {
+
+        for (const double fill : FILLS) {
+            for (size_t patternID = 0; patternID < static_cast<size_t>(Pattern::COUNT); ++patternID) {
+
+                if (fill == 1.0 && patternID != 0) {
+                    continue;
+                }
+
+                const Pattern pattern = static_cast<Pattern>(patternID);
+
+                const std::vector<size_t> order = MakeDeallocationOrder(count, pattern);
+                const size_t numToDeallocate = count - static_cast<size_t>(static_cast<double>(count) * fill);
+
+                ProcessMemory::TrimHeap();
+                ProcessMemory::ResetPeakRSS();
+
+                const int64_t baseRSS = static_cast<int64_t>(ProcessMemory::GetRSS());
+                const int64_t basePeakRSS = static_cast<int64_t>(ProcessMemory::GetPeakRSS());
+
+                Container container{};
+                container.Reset(count);
+
+                size_t numAlive = 0;
+
+                const auto takeFootprint = [&](const Phase phase) {
+
+                    FootprintResult result{};
+                    result.container = Container::NAME;
+                    result.elementSizeInBytes = elementSizeInBytes;
+                    result.pattern = pattern;
+                    result.fill = fill;
+                    result.phase = phase;
+
+                    result.numAlive = numAlive;
+                    result.requestedSizeInBytes = numAlive * elementSizeInBytes;
+                    result.footprint = container.GetFootprint();
+
+                    result.rssDelta = static_cast<int64_t>(ProcessMemory::GetRSS()) - baseRSS;
+                    result.peakRSSDelta = static_cast<int64_t>(ProcessMemory::GetPeakRSS()) - basePeakRSS;
+
+                    Print(result);
+
+                    _footprintResults.push_back(result);
+                };
+
+                for (size_t i = 0; i < count; ++i) {
+                    container.Allocate(i);
+                }
+
+                numAlive = count;
+                takeFootprint(Phase::Fill);
+
+                for (size_t i = 0; i < numToDeallocate; ++i) {
+                    container.Deallocate(order[i]);
+                }
+
+                numAlive -= numToDeallocate;
+                takeFootprint(Phase::Delete);
+
+                for (size_t i = 0; i < numToDeallocate; ++i) {
+                    container.Allocate(order[i]);
+                }
+
+                numAlive = count;
+                takeFootprint(Phase::Refill);
+
+                for (size_t i = 0; i < count; ++i) {
+                    container.Deallocate(i);
+                }
+
+                numAlive = 0;
+                takeFootprint(Phase::Drain);
+            }
+        }
+    }
+
+    template <typename Container>
+    void RunContainer(const size_t elementSizeInBytes, const size_t count) {
+
+        for (const double fill : FILLS) {
+            for (size_t patternID = 0; patternID < static_cast<size_t>(Pattern::COUNT); ++patternID) {
+
+                // Nothing is deleted, so the pattern doesn't matter
+                if (fill == 1.0 && patternID != 0) {
+                    continue;
+                }
+
+                const Pattern pattern = static_cast<Pattern>(patternID);
+
+                Samples samples{};
+
+                for (size_t rep = 0; rep < _opt.warmup + _opt.reps; ++rep) {
+
+                    Samples repSamples{};
+                    RunOnce<Container>(count, pattern, fill, repSamples);
+
+                    if (rep < _opt.warmup) {
+                        continue;
+                    }
+
+                    for (size_t op = 0; op < Op::COUNT; ++op) {
+
+                        OpSamples& opSamples = samples[op];
+                        const OpSamples& repOpSamples = repSamples[op];
+
+                        opSamples.nsPerOp.insert(
+                            opSamples.nsPerOp.end(), repOpSamples.nsPerOp.begin(), repOpSamples.nsPerOp.end()
+                        );
+
+                        for (size_t i = 0; i < PerfCounters::Counter::COUNT; ++i) {
+                            opSamples.counters[i] += repOpSamples.counters[i];
+                        }
+
+                        opSamples.numOps += repOpSamples.numOps;
+                    }
+                }
+
+                for (size_t op = 0; op < Op::COUNT; ++op) {
+
+                    if (samples[op].nsPerOp.empty()) {
+                        continue;
+                    }
+
+                    Result result{};
+                    result.container = Container::NAME;
+                    result.elementSizeInBytes = elementSizeInBytes;
+                    result.pattern = pattern;
+                    result.fill = fill;
+                    result.op = static_cast<Op>(op);
+
+                    Reduce(samples[op], result);
+                    Print(result);
+
+                    _results.push_back(result);
+                }
+            }
+        }
+    }
+
+    template <size_t SIZE_IN_BYTES>
+    void RunSmallPoolsElementSize() {
+
+        using T = Element<SIZE_IN_BYTES>;
+
+        const size_t count = std::max<size_t>(std::min(_opt.count, _opt.maxBytes / SIZE_IN_BYTES), 1);
+        const size_t poolsCnt = std::max<size_t>(count / SMALL_POOL_SIZE, 1);
+
+        printf("Element %zu bytes, %zu pools of %zu elements:\n", SIZE_IN_BYTES, poolsCnt, SMALL_POOL_SIZE);
+
+        for (const size_t initialSubPoolSize : SMALL_POOL_INITIAL_SIZES) {
+            for (const double fill : FILLS) {
+
+                OpSamples samples{};
+
+                for (size_t rep = 0; rep < _opt.warmup + _opt.reps; ++rep) {
+
+                    OpSamples repSamples{};
+                    RunSmallPoolsOnce<T>(poolsCnt, initialSubPoolSize, fill, repSamples);
+
+                    if (rep < _opt.warmup) {
+                        continue;
+                    }
+
+                    samples.nsPerOp.insert(samples.nsPerOp.end(), repSamples.nsPerOp.begin(), repSamples.nsPerOp.end());
+
+                    for (size_t i = 0; i < PerfCounters::Counter::COUNT; ++i) {
+                        samples.counters[i] += repSamples.counters[i];
+                    }
+
+                    samples.numOps += repSamples.numOps;
+                }
+
+                Result result{};
+                result.container = "KoPool initial " + std::to_string(initialSubPoolSize);
+                result.elementSizeInBytes = SIZE_IN_BYTES;
+                result.pattern = Pattern::Random;
+                result.fill = fill;
+                result.op = Op::Iterate;
+
+                Reduce(samples, result);
+                Print(result);
+
+                _results.push_back(result);
+            }
+        }
+
+        printf("--------------------------\n");
+    }
+
+    // Fills 'poolsCnt' pools round robin, so the sub pools of the pools interleave in the heap like in an application
+    // with many small containers, deallocates random elements until 'fill' of them are alive and iterates all pools
+    template <typename T>
+    void RunSmallPoolsOnce(const size_t poolsCnt, const size_t initialSubPoolSize, const double fill, OpSamples& samples) {
+
+        KoPoolIteratable::Opt poolOpt{ sizeof(T), alignof(T) };
+        poolOpt.initialSubPoolSize = initialSubPoolSize;
+
+        std::vector<KoPoolIteratable> pools;
+        pools.reserve(poolsCnt);
+
+        for (size_t i = 0; i < poolsCnt; ++i) {
+            pools.emplace_back(poolOpt);
+        }
+
+        const size_t count = poolsCnt * SMALL_POOL_SIZE;
+
+        std::vector<T*> pointers(count, nullptr);
+        for (size_t i = 0; i < SMALL_POOL_SIZE; ++i) {
+            for (size_t poolID = 0; poolID < poolsCnt; ++poolID) {
+                pointers[poolID * SMALL_POOL_SIZE + i] = pools[poolID].Allocate<T>();
+            }
+        }
+
+        const std::vector<size_t> order = MakeDeallocationOrder(count, Pattern::Random);
+        const size_t numToDeallocate = count - static_cast<size_t>(static_cast<double>(count) * fill);
+
+        for (size_t i = 0; i < numToDeallocate; ++i) {
+            pools[order[i] / SMALL_POOL_SIZE].Deallocate(pointers[order[i]]);
+        }
+
+        const size_t numAlive = count - numToDeallocate;
+
+        for (size_t i = 0; i < ITERATIONS_PER_RUN; ++i) {
+
+            TimeBatch(samples, std::max<size_t>(numAlive, 1), [&]() {
+
+                size_t cnt = 0;
+                for (const KoPoolIteratable& pool : pools) {
+
+                    KoPoolIterator<T> iterator = pool.GetIterator<T>();
+                    while (const T* pData = iterator.Next()) {
+                        cnt += pData->cnt;
+                    }
+                }
+
+                DoNotOptimize(cnt);
+
+                BenchAssert(cnt == numAlive);
+            });
+        }
+    }
+
+    // Allocates 'count' elements, deallocates them by 'pattern' until 'fill' of them are alive, iterates the rest
+    template <typename Container>
+    void RunOnce(const size_t count, const Pattern pattern, const double fill, Samples& samples) {
+
+        Container container{};
+        container.Reset(count);
+
+        for (size_t begin = 0; begin < count; begin += _opt.batchSize) {
+
+            const size_t end = std::min(begin + _opt.batchSize, count);
+
+            TimeBatch(samples[Op::Allocate], end - begin, [&]() {
+
+                for (size_t i = begin; i < end; ++i) {
+                    container.Allocate(i);
+                }
+            });
+        }
+
+        const std::vector<size_t> order = MakeDeallocationOrder(count, pattern);
+        const size_t numToDeallocate = count - static_cast<size_t>(static_cast<double>(count) * fill);
+
+        for (size_t begin = 0; begin < numToDeallocate; begin += _opt.batchSize) {
+
+            const size_t end = std::min(begin + _opt.batchSize, numToDeallocate);
+
+            TimeBatch(samples[Op::Deallocate], end - begin, [&]() {
+
+                for (size_t i = begin; i < end; ++i) {
+                    container.Deallocate(order[i]);
+                }
+            });
+        }
+
+        const size_t numAlive = count - numToDeallocate;
+
+        // Each sample is a full iteration, so it is timed a few times
+        for (size_t i = 0; i < ITERATIONS_PER_RUN; ++i) {
+
+            TimeBatch(samples[Op::Iterate], std::max<size_t>(numAlive, 1), [&]() {
+
+                const size_t cnt = container.Iterate();
+                DoNotOptimize(cnt);
+
+                BenchAssert(cnt == numAlive);
+            });
+        }
+
+        // Not timed
+        for (size_t i = numToDeallocate; i < count; ++i) {
+            container.Deallocate(order[i]);
+        }
+    }
+
+    std::vector<size_t> MakeDeallocationOrder(const size_t count, const Pattern pattern) {
+
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+
+        switch (pattern) {
+        case Pattern::FIFO:
+            break;
+
+        case Pattern::LIFO:
+            std::reverse(order.begin(), order.end());
+            break;
+
+        case Pattern::Random:
+            std::shuffle(order.begin(), order.end(), _rng);
+            break;
+
+        case Pattern::Bursty: {
+
+            std::uniform_int_distribution<size_t> burstLength{ 1, BURST_LENGTH_MAX };
+
+            std::vector<std::pair<size_t, size_t>> bursts;
+            for (size_t begin = 0; begin < count;) {
+
+                const size_t end = std::min(begin + burstLength(_rng), count);
+                bursts.emplace_back(begin, end);
+                begin = end;
+            }
+
+            std::shuffle(bursts.begin(), bursts.end(), _rng);
+
+            order.clear();
+            for (const std::pair<size_t, size_t>& burst : bursts) {
+                for (size_t i = burst.first; i < burst.second; ++i) {
+                    order.push_back(i);
+                }
+            }
+
+            break;
+        }
+
+        default:
+            BenchAssert(false);
+        }
+
+        return order;
+    }
+
+    template <typename Func>
+    void TimeBatch(OpSamples& samples, const size_t numOps, Func&& func) {
+
+        const PerfCounters::Values startCounters = _counters.Read();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        (func)();
+
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        const PerfCounters::Values endCounters = _counters.Read();
+
+        const std::chrono::duration<double, std::nano> duration = end - start;
+        samples.nsPerOp.push_back(duration.count() / static_cast<double>(numOps));
+
+        for (size_t i = 0; i < PerfCounters::Counter::COUNT; ++i) {
+            samples.counters[i] += endCounters[i] - startCounters[i];
+        }
+
+        samples.numOps += numOps;
+    }
+
+    static void Reduce(OpSamples& samples, Result& result) {
+
+        std::vector<double>& nsPerOp = samples.nsPerOp;
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+
+        const auto percentile = [&](const double p) {
+            const size_t id = static_cast<size_t>(p * static_cast<double>(nsPerOp.size() - 1) + 0.5);
+            return nsPerOp[id];
+        };
+
+        result.numSamples = nsPerOp.size();
+        result.nsPerOpMean = std::accumulate(nsPerOp.begin(), nsPerOp.end(), 0.0) / static_cast<double>(nsPerOp.size());
+        result.nsPerOpP50 = percentile(0.5);
+        result.nsPerOpP99 = percentile(0.99);
+        result.nsPerOpP999 = percentile(0.999);
+
+        for (size_t i = 0; i < PerfCounters::Counter::COUNT; ++i) {
+            result.countersPerOp[i] = samples.counters[i] / static_cast<double>(samples.numOps);
+        }
+    }
+
+    void Print(const Result& result) const {
+
+        printf(
+            "[%s] %-10s %-6s fill %3.0f%%: p50 %9.2fns p99 %9.2fns p999 %9.2fns mean %9.2fns (%zu samples)",
+            result.container.c_str(),
+            OP_TO_STR[result.op],
+            PATTERN_TO_STR[static_cast<size_t>(result.pattern)],
+            result.fill * 100.0,
+            result.nsPerOpP50,
+            result.nsPerOpP99,
+            result.nsPerOpP999,
+            result.nsPerOpMean,
+            result.numSamples
+        );
+
+        for (size_t i = 0; i < PerfCounters::Counter::COUNT; ++i) {
+
+            const PerfCounters::Counter counter = static_cast<PerfCounters::Counter>(i);
+            if (_counters.IsAvailable(counter)) {
+                printf(" %s/op %.3f", PerfCounters::COUNTER_TO_STR[counter], result.countersPerOp[counter]);
+            }
+        }
+
+        printf("\n");
+    }
+
+    static void Print(const FootprintResult& result) {
+
+        const auto toMiB = [](const double sizeInBytes) {
+            return sizeInBytes / (1024.0 * 1024.0);
+        };
+
+        printf(
+            "[%s] %-6s %-6s fill %3.0f%%: alive %8zu requested %8.2fMiB data %8.2fMiB bitmap %7.3fMiB "
+            "metadata %7.3fMiB rss %+8.2fMiB peak %+8.2fMiB\n",
+            result.container.c_str(),
+            PHASE_TO_STR[result.phase],
+            PATTERN_TO_STR[static_cast<size_t>(result.pattern)],
+            result.fill * 100.0,
+            result.numAlive,
+            toMiB(static_cast<double>(result.requestedSizeInBytes)),
+            toMiB(static_cast<double>(result.footprint.dataSizeInBytes)),
+            toMiB(static_cast<double>(result.footprint.skipBitmapSizeInBytes)),
+            toMiB(static_cast<double>(result.footprint.metadataSizeInBytes)),
+            toMiB(static_cast<double>(result.rssDelta)),
+            toMiB(static_cast<double>(result.peakRSSDelta))
+        );
+    }
+
+    void WriteJson() const {
+
+        FILE* pFile = fopen(_opt.jsonPath.c_str(), "w");
+        if (!pFile) {
+
+            fprintf(stderr, "Can't open '%s'\n", _opt.jsonPath.c_str());
+            return;
+        }
+
+        fprintf(pFile, "{\n");
+        fprintf(
+            pFile, "  \"opt\": { \"count\": %zu, \"reps\": %zu, \"warmup\": %zu, \"batchSize\": %zu, \"counters\": %s },\n",
+            _opt.count, _opt.reps, _opt.warmup, _opt.batchSize, _counters.IsAnyAvailable() ? "true" : "false"
+        );
+        fprintf(pFile, "  \"results\": [\n");
+
+        for (size_t i = 0; i < _results.size(); ++i) {
+
+            const Result& result = _results[i];
+
+            fprintf(
+                pFile,
+                "    { \"container\": \"%s\", \"elementSizeInBytes\": %zu, \"pattern\": \"%s\", \"fill\": %.2f, "
+                "\"op\": \"%s\", \"samples\": %zu, \"nsPerOpMean\": %.3f, \"nsPerOpP50\": %.3f, "
+                "\"nsPerOpP99\": %.3f, \"nsPerOpP999\": %.3f, \"perOp\": {",
+                result.container.c_str(),
+                result.elementSizeInBytes,
+                PATTERN_TO_STR[static_cast<size_t>(result.pattern)],
+                result.fill,
+                OP_TO_STR[result.op],
+                result.numSamples,
+                result.nsPerOpMean,
+                result.nsPerOpP50,
+                result.nsPerOpP99,
+                result.nsPerOpP999
+            );
+
+            // Unavailable counters are 'null'
+            for (size_t j = 0; j < PerfCounters::Counter::COUNT; ++j) {
+
+                const PerfCounters::Counter counter = static_cast<PerfCounters::Counter>(j);
+
+                fprintf(pFile, "%s \"%s\": ", j > 0 ? "," : "", PerfCounters::COUNTER_TO_STR[counter]);
+
+                if (_counters.IsAvailable(counter)) {
+                    fprintf(pFile, "%.3f", result.countersPerOp[counter]);
+                }
+                else {
+                    fprintf(pFile, "null");
+                }
+            }
+
+            fprintf(pFile, " } }%s\n", i + 1 < _results.size() ? "," : "");
+        }
+
+        fprintf(pFile, "  ],\n");
+        fprintf(pFile, "  \"footprints\": [\n");
+
+        for (size_t i = 0; i < _footprintResults.size(); ++i) {
+
+            const FootprintResult& result = _footprintResults[i];
+
+            fprintf(
+                pFile,
+                "    { \"container\": \"%s\", \"elementSizeInBytes\": %zu, \"pattern\": \"%s\", \"fill\": %.2f, "
+                "\"phase\": \"%s\", \"alive\": %zu, \"requestedSizeInBytes\": %zu, \"dataSizeInBytes\": %zu, "
+                "\"skipBitmapSizeInBytes\": %zu, \"metadataSizeInBytes\": %zu, \"rssDelta\": %lld, "
+                "\"peakRSSDelta\": %lld }%s\n",
+                result.container.c_str(),
+                result.elementSizeInBytes,
+                PATTERN_TO_STR[static_cast<size_t>(result.pattern)],
+                result.fill,
+                PHASE_TO_STR[result.phase],
+                result.numAlive,
+                result.requestedSizeInBytes,
+                result.footprint.dataSizeInBytes,
+                result.footprint.skipBitmapSizeInBytes,
+                result.footprint.metadataSizeInBytes,
+                static_cast<long long>(result.rssDelta),
+                static_cast<long long>(result.peakRSSDelta),
+                i + 1 < _footprintResults.size() ? "," : ""
+            );
+        }
+
+        fprintf(pFile, "  ]\n}\n");
+        fclose(pFile);
+    }
+
+private:
+
+    static constexpr size_t ITERATIONS_PER_RUN = 4;
+
+    Opt _opt;
+    PerfCounters _counters;
+
+    std::mt19937_64 _rng{ 0x4B6F506F6F6CULL };
+    std::vector<Result> _results;
+    std::vector<FootprintResult> _footprintResults;
+};
+
+int main(int argc, char** argv) {
+
+    Bench::Opt opt{};
+
+    for (int i = 1; i < argc; ++i) {
+
+        const bool hasValue = i + 1 < argc;
+
+        if (hasValue && std::strcmp(argv[i], "--count") == 0) {
+            opt.count = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (hasValue && std::strcmp(argv[i], "--reps") == 0) {
+            opt.reps = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (hasValue && std::strcmp(argv[i], "--warmup") == 0) {
+            opt.warmup = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (hasValue && std::strcmp(argv[i], "--batch") == 0) {
+            opt.batchSize = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        }
+        else if (hasValue && std::strcmp(argv[i], "--json") == 0) {
+            opt.jsonPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--no-counters") == 0) {
+            opt.isCountersEnabled = false;
+        }
+        else if (std::strcmp(argv[i], "--footprint") == 0) {
+            opt.isFootprint = true;
+        }
+        else if (std::strcmp(argv[i], "--small-pools") == 0) {
+            opt.isSmallPools = true;
+        }
+        else {
+
+            fprintf(stderr, "Usage: %s [--count N] [--reps N] [--warmup N] [--batch N] [--json path] [--no-counters] [--footprint] [--small-pools]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Bench bench{ opt };
+    bench.Run();
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "KoPoolBlockCache.h"
+#include "KoPoolMemoryUtils.h"
+
+namespace {
+
+    using KoPoolMemoryUtils::AlignedMalloc;
+    using KoPoolMemoryUtils::AlignedFree;
+}
+
+KoPoolBlockCache::KoPoolBlockCache() noexcept
+    : KoPoolBlockCache(Opt{})
+{}
+
+KoPoolBlockCache::KoPoolBlockCache(const Opt& opt) noexcept
+    : _opt(opt)
+{}
+
+KoPoolBlockCache::~KoPoolBlockCache() noexcept {
+    Clear();
+}
+
+KoPoolIteratable::BlockAllocator KoPoolBlockCache::GetBlockAllocator() noexcept {
+
+    KoPoolIteratable::BlockAllocator blockAllocator{};
+    blockAllocator.pAllocate = &KoPoolBlockCache::AllocateBlock;
+    blockAllocator.pDeallocate = &KoPoolBlockCache::DeallocateBlock;
+    blockAllocator.pUserData = this;
+
+    return blockAllocator;
+}
+
+void* KoPoolBlockCache::Allocate(const USize sizeInBytes, const USize alignment) noexcept {
+
+    if (sizeInBytes <= _opt.maxBlockSizeInBytes && sizeInBytes >= sizeof(FreeBlock)) {
+
+        const std::unique_lock<std::mutex> lock = Lock();
+
+        Bucket* pBucket = FindBucket(Key{ sizeInBytes, alignment }, false);
+        if (pBucket && pBucket->pHead) {
+
+            FreeBlock* pBlock = pBucket->pHead;
+            pBucket->pHead = pBlock->pNext;
+
+            _stats.numHits += 1;
+            _stats.numBlocksCached -= 1;
+            _stats.numBytesCached -= sizeInBytes;
+
+            return pBlock;
+        }
+
+        _stats.numMisses += 1;
+    }
+
+    return AlignedMalloc(sizeInBytes, alignment);
+}
+
+void KoPoolBlockCache::Deallocate(void* pMemory, const USize sizeInBytes, const USize alignment) noexcept {
+
+    if (!pMemory) {
+        return;
+    }
+
+    if (sizeInBytes <= _opt.maxBlockSizeInBytes && sizeInBytes >= sizeof(FreeBlock)) {
+
+        const std::unique_lock<std::mutex> lock = Lock();
+
+        Bucket* pBucket = _stats.numBytesCached + sizeInBytes <= _opt.maxCachedBytes
+            ? FindBucket(Key{ sizeInBytes, alignment }, true)
+            : nullptr;
+
+        if (pBucket) {
+
+            FreeBlock* pBlock = new (pMemory) FreeBlock{};
+            pBlock->pNext = pBucket->pHead;
+            pBucket->pHead = pBlock;
+
+            _stats.numBlocksCached += 1;
+            _stats.numBytesCached += sizeInBytes;
+
+            return;
+        }
+    }
+
+    AlignedFree(pMemory);
+}
+
+void KoPoolBlockCache::Clear() noexcept {
+
+    const std::unique_lock<std::mutex> lock = Lock();
+
+    for (Bucket& bucket : _buckets) {
+
+        while (bucket.pHead) {
+
+            FreeBlock* pNext = bucket.pHead->pNext;
+            AlignedFree(bucket.pHead);
+            bucket.pHead = pNext;
+        }
+
+        bucket.key = Key{};
+    }
+
+    _stats.numBlocksCached = 0;
+    _stats.numBytesCached = 0;
+}
+
+KoPoolBlockCache::Stats KoPoolBlockCache::GetStats() const noexcept {
+
+    const std::unique_lock<std::mutex> lock = Lock();
+    return _stats;
+}
+
+void* KoPoolBlockCache::AllocateBlock(void* pUserData, USize sizeInBytes, USize alignment, USize /*subPoolID*/) noexcept {
+
+    return reinterpret_cast<KoPoolBlockCache*>(pUserData)->Allocate(sizeInBytes, alignment);
+}
+
+void KoPoolBlockCache::DeallocateBlock(
+    void* pUserData, void* pMemory, USize sizeInBytes, USize alignment, USize /*subPoolID*/
+) noexcept {
+
+    reinterpret_cast<KoPoolBlockCache*>(pUserData)->Deallocate(pMemory, sizeInBytes, alignment);
+}
+
+std::unique_lock<std::mutex> KoPoolBlockCache::Lock() const noexcept {
+
+    return _opt.isThreadSafe
+        ? std::unique_lock<std::mutex>{ _mutex }
+        : std::unique_lock<std::mutex>{};
+}
+
+KoPoolBlockCache::Bucket* KoPoolBlockCache::FindBucket(const Key& key, const bool isInsert) noexcept {
+
+    const USize hash = key.sizeInBytes * 31 + key.alignment;
+
+    for (USize i = 0; i < BUCKETS_CNT; ++i) {
+
+        Bucket& bucket = _buckets[(hash + i) & (BUCKETS_CNT - 1)];
+
+        if (bucket.key == key) {
+            return &bucket;
+        }
+
+        // The keys aren't removed until 'Clear()', so a vacant bucket ends the probe
+        if (bucket.key.sizeInBytes == 0) {
+
+            if (!isInsert) {
+                return nullptr;
+            }
+
+            bucket.key = key;
+            return &bucket;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+
+#include "KoPoolIteratable.h"
+
+// Cache of the released blocks shared by many pools, keyed by (size, alignment). Set 'GetBlockAllocator()' to
+// 'KoPoolIteratable::Opt::subPoolAllocator' and/or 'metadataAllocator', so the small sub pools, the skip bit sets
+// and the 'SubPools' metadata of one pool are reused by the next pool instead of going to malloc. Thread safe
+// if 'Opt::isThreadSafe'. Must outlive the pools
+class KoPoolBlockCache {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    struct Opt {
+
+        bool isThreadSafe = false;
+
+        // Bigger blocks aren't cached
+        USize maxBlockSizeInBytes = 64 * 1024;
+
+        // Released blocks are freed when the cache is full
+        USize maxCachedBytes = 16 * 1024 * 1024;
+    };
+
+    struct Stats {
+
+        USize numHits = 0;
+        USize numMisses = 0;
+
+        USize numBlocksCached = 0;
+        USize numBytesCached = 0;
+    };
+
+    KoPoolBlockCache() noexcept;
+    KoPoolBlockCache(const Opt& opt) noexcept;
+
+    // Frees all cached blocks
+    ~KoPoolBlockCache() noexcept;
+
+    // Pools store pointers to the cache
+    KoPoolBlockCache(const KoPoolBlockCache&) = delete;
+    KoPoolBlockCache& operator=(const KoPoolBlockCache&) = delete;
+
+    KoPoolIteratable::BlockAllocator GetBlockAllocator() noexcept;
+
+    void* Allocate(const USize sizeInBytes, const USize alignment) noexcept;
+    void Deallocate(void* pMemory, const USize sizeInBytes, const USize alignment) noexcept;
+
+    // Frees all cached blocks
+    void Clear() noexcept;
+
+    Stats GetStats() const noexcept;
+
+private:
+
+    struct Key {
+
+        USize sizeInBytes = 0;
+        USize alignment = 0;
+
+        bool operator==(const Key& rhs) const noexcept {
+            return sizeInBytes == rhs.sizeInBytes && alignment == rhs.alignment;
+        }
+    };
+
+    // Stored in the cached block
+    struct FreeBlock {
+        FreeBlock* pNext = nullptr;
+    };
+
+    // Free list of the blocks of a key, 'key.sizeInBytes' == 0 - vacant
+    struct Bucket {
+
+        Key key;
+        FreeBlock* pHead = nullptr;
+    };
+
+    // Power of 2, the keys are the distinct block sizes of the pools, a sub pool ID gives a few of them.
+    // Blocks of a new key are freed when all buckets are taken
+    static constexpr USize BUCKETS_CNT = 256;
+
+    static void* AllocateBlock(void* pUserData, USize sizeInBytes, USize alignment, USize subPoolID) noexcept;
+    static void DeallocateBlock(void* pUserData, void* pMemory, USize sizeInBytes, USize alignment, USize subPoolID) noexcept;
+
+    std::unique_lock<std::mutex> Lock() const noexcept;
+
+    // Linear probing over '_buckets', 'nullptr' if the key isn't found ('isInsert' == false) or all buckets are taken
+    Bucket* FindBucket(const Key& key, const bool isInsert) noexcept;
+
+private:
+
+    Opt _opt;
+
+    mutable std::mutex _mutex;
+
+    // Fixed, so a cached deallocation doesn't allocate a map node in the 'noexcept' hooks
+    std::array<Bucket, BUCKETS_CNT> _buckets{};
+
+    Stats _stats;
+};
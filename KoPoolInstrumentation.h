@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Latency histograms of the hot path of 'KoPoolIteratable', enabled by '__KO_POOL_ITERATABLE_INSTRUMENTATION__'.
+// Ticks are 'rdtsc' cycles on x86, otherwise 'std::chrono::steady_clock' nanoseconds
+class KoPoolInstrumentation {
+public:
+
+    enum Event : size_t {
+
+        AllocateBytes,
+        DeallocateBytes,
+        FindSortedPointerIDByPtr,
+
+        SubPoolGrow,
+        SubPoolRelease,
+
+        COUNT
+    };
+
+    static constexpr std::array<const char*, Event::COUNT> EVENT_TO_STR{
+
+        "AllocateBytes",
+        "DeallocateBytesImpl",
+        "FindSortedPointerIDByPtr",
+
+        "SubPoolGrow",
+        "SubPoolRelease",
+    };
+
+    struct Histogram {
+
+        // 'buckets[i]' is the number of samples which ticks is in [2^i, 2^(i + 1)), 0 ticks are in 'buckets[0]'
+        std::array<uint64_t, 64> buckets{};
+
+        uint64_t cnt = 0;
+        uint64_t totalTicks = 0;
+        uint64_t maxTicks = 0;
+
+        // Upper bound of the bucket which contains the percentile, 'percentile' in [0, 1]
+        uint64_t GetPercentileTicks(const double percentile) const noexcept {
+
+            if (cnt == 0) {
+                return 0;
+            }
+
+            const uint64_t rank = static_cast<uint64_t>(percentile * static_cast<double>(cnt - 1)) + 1;
+
+            uint64_t accum = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+
+                accum += buckets[i];
+                if (accum >= rank) {
+                    return i + 1 < 64 ? (static_cast<uint64_t>(1) << (i + 1)) - 1 : maxTicks;
+                }
+            }
+
+            return maxTicks;
+        }
+    };
+
+    class Scope {
+    public:
+
+        Scope(KoPoolInstrumentation& instrumentation, const Event event) noexcept
+            : _pInstrumentation(&instrumentation)
+            , _event(event)
+            , _startTicks(ReadTicks())
+        {}
+
+        ~Scope() noexcept {
+            _pInstrumentation->Record(_event, ReadTicks() - _startTicks);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+
+        KoPoolInstrumentation* _pInstrumentation = nullptr;
+        Event _event = Event::COUNT;
+        uint64_t _startTicks = 0;
+    };
+
+    static uint64_t ReadTicks() noexcept {
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count()
+        );
+#endif
+    }
+
+    // Defined in 'KoPoolIteratable.cpp', it takes the bucket by 'KoPoolIteratable::Count0BitsLeft(...)'
+    void Record(const Event event, const uint64_t ticks) noexcept;
+
+    const Histogram& GetHistogram(const Event event) const noexcept {
+        return _histograms[event];
+    }
+
+    void Reset() noexcept {
+        _histograms = {};
+    }
+
+private:
+
+    std::array<Histogram, Event::COUNT> _histograms{};
+};
+
+#define __KO_POOL_INSTRUMENTATION_CONCAT_MACROS__0(x, y) x##y
+#define __KO_POOL_INSTRUMENTATION_CONCAT_MACROS__(x, y) __KO_POOL_INSTRUMENTATION_CONCAT_MACROS__0(x, y)
+
+#define __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(instrumentation, event) \
+    KoPoolInstrumentation::Scope __KO_POOL_INSTRUMENTATION_CONCAT_MACROS__(_instrumentation_scope_, __COUNTER__){ \
+        (instrumentation), KoPoolInstrumentation::event \
+    }
@@ -1,20 +1,64 @@
 #include "KoPoolIteratable.h"
+#include "KoPoolMemoryUtils.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace {
 
-    inline void* AlignedMalloc(const size_t sizeInBytes, const size_t alignment) noexcept {
-#if defined(_MSC_VER)
-        return _aligned_malloc(sizeInBytes, alignment);
+    using KoPoolMemoryUtils::AlignedMalloc;
+    using KoPoolMemoryUtils::AlignedFree;
+    using KoPoolMemoryUtils::RoundUp;
+
+    inline size_t GetPageSizeInBytes() noexcept {
+
+        static const size_t pageSizeInBytes = []() -> size_t {
+#if defined(_WIN32)
+            SYSTEM_INFO systemInfo{};
+            GetSystemInfo(&systemInfo);
+            return systemInfo.dwPageSize;
+#else
+            return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+        }();
+
+        return pageSizeInBytes;
+    }
+
+    // Pages are committed on the first touch
+    inline void* MapPages(const size_t sizeInBytes) noexcept {
+#if defined(_WIN32)
+        return VirtualAlloc(nullptr, sizeInBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+        void* pMemory = mmap(nullptr, sizeInBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return pMemory != MAP_FAILED ? pMemory : nullptr;
+#endif
+    }
+
+    inline void UnmapPages(void* pMemory, const size_t sizeInBytes) noexcept {
+#if defined(_WIN32)
+        (void)sizeInBytes;
+        VirtualFree(pMemory, 0, MEM_RELEASE);
 #else
-        return std::aligned_alloc(alignment, sizeInBytes);
+        munmap(pMemory, sizeInBytes);
 #endif
     }
 
-    inline void AlignedFree(void* ptr) noexcept {
-#if defined(_MSC_VER)
-        _aligned_free(ptr);
+    // The content of the pages is undefined after, the pages stay accessible
+    inline void DiscardPages(void* pMemory, const size_t sizeInBytes) noexcept {
+#if defined(_WIN32)
+        VirtualAlloc(pMemory, sizeInBytes, MEM_RESET, PAGE_READWRITE);
 #else
-        std::free(ptr);
+        madvise(pMemory, sizeInBytes, MADV_DONTNEED);
 #endif
     }
 
@@ -48,36 +92,69 @@ void KoPoolIteratable::SubPoolsUniquePtrDeleter::operator()(SubPools* ptr) const
 
     for (USize i = 0; i < static_cast<USize>(ptr->pointers.size()); ++i) {
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
+        // Use 'DeallocateAll()' or 'Opt::elementDestructor' if you want to call all destructors and deallocate all memory in one call
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(ptr->pools[i].numUsed == 0 || ptr->opt.elementDestructor.pDestroy);
 
-        // Use 'DeallocateAll()' if you want to call all destructors and deallocate all memory in one call
-        __KO_POOL_ITERATABLE_ASSERT_DEV__(ptr->pools[i].numUsed == 0);
-#endif
+        DestroySubPoolElements(*ptr, i);
 
+        ptr->pools[i].numUsed = 0;
         DeallocateSubPoolMemory(*ptr, i);
     }
 
     ptr->sortedPointersSize = 0;
-    ptr->sortedPointers = { SortedPointer{} };
+    ptr->sortedPointers = { nullptr };
 
-    AlignedFree(ptr);
+    // 'ptr' stores the allocator
+    const BlockAllocator metadataAllocator = ptr->opt.metadataAllocator;
+    DeallocateMetadata(metadataAllocator, ptr, sizeof(SubPools), alignof(SubPools), SUB_POOL_ID_NONE);
 }
 
 KoPoolIteratable::KoPoolIteratable(const Opt& opt) noexcept {
 
     __KO_POOL_ITERATABLE_ASSERT_DEV__(IsPowerOf2(opt.elementAlignment));
-    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.elementSizeInBytes >= sizeof(SkipNodeHead));
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.elementSizeInBytes >= MIN_ELEMENT_SIZE_IN_BYTES);
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(!opt.subPoolAllocator.pAllocate == !opt.subPoolAllocator.pDeallocate);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(!opt.metadataAllocator.pAllocate == !opt.metadataAllocator.pDeallocate);
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.columnsCnt > 0 && opt.columnsCnt <= COLUMNS_CNT_MAX);
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.maxSubPoolSize == 0 || (IsPowerOf2(opt.maxSubPoolSize) && opt.maxSubPoolSize >= 2));
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(IsPowerOf2(opt.initialSubPoolSize) && opt.initialSubPoolSize >= 2);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(IsPowerOf2(opt.growthFactor) && opt.growthFactor >= 2);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.maxSubPoolSize == 0 || opt.maxSubPoolSize >= opt.initialSubPoolSize);
+
+    _opt = opt;
+    _opt.elementAlignment = std::max(opt.elementAlignment, static_cast<USize>(alignof(SkipNodeHead)));
+
+    // The block of the sub pool starts with the skip bit set
+    if (_opt.isSkipBitmapColocated) {
+        _opt.elementAlignment = std::max(_opt.elementAlignment, static_cast<USize>(alignof(USize)));
+    }
+
+    for (USize i = 1; i < _opt.columnsCnt; ++i) {
 
-    _opt.elementSizeInBytes = opt.elementSizeInBytes;
-    _opt.elementAlignment = std::max(opt.elementAlignment, alignof(SkipNodeHead));
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(IsPowerOf2(opt.columnAlignments[i]));
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.columnSizesInBytes[i] % opt.columnAlignments[i] == 0);
+
+        _opt.elementAlignment = std::max(_opt.elementAlignment, opt.columnAlignments[i]);
+    }
+
+    _layout = MakeLayout(_opt);
 }
 
 KoPoolIteratable::KoPoolIteratable(KoPoolIteratable&& rhs) noexcept
-    : _opt(std::exchange(rhs._opt, Opt{}))
-    , _vacantSubPools(std::exchange(rhs._vacantSubPools, std::numeric_limits<USize>::max()))
-    , _subPoolsWhichHaveAtLeastOneElement(std::exchange(rhs._subPoolsWhichHaveAtLeastOneElement, 0))
+    : _vacantSubPools(std::exchange(rhs._vacantSubPools, MakeSubPoolsMaskFull()))
+    , _subPoolsWhichHaveAtLeastOneElement(std::exchange(rhs._subPoolsWhichHaveAtLeastOneElement, SubPoolsMask{}))
     , _subPoolToDeallocate(std::exchange(rhs._subPoolToDeallocate, SUB_POOL_ID_NONE))
+    , _generation(rhs._generation++)
     , _pSubPools(std::exchange(rhs._pSubPools, nullptr))
+    , _deferredDeallocations(std::exchange(rhs._deferredDeallocations, std::vector<DeferredDeallocation>{}))
+    , _opt(std::exchange(rhs._opt, Opt{}))
+    , _layout(std::exchange(rhs._layout, MakeLayout(Opt{})))
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+    , _instrumentation(std::exchange(rhs._instrumentation, KoPoolInstrumentation{}))
+#endif
 {}
 
 KoPoolIteratable& KoPoolIteratable::operator=(KoPoolIteratable&& rhs) noexcept {
@@ -87,84 +164,298 @@ KoPoolIteratable& KoPoolIteratable::operator=(KoPoolIteratable&& rhs) noexcept {
     }
 
     _opt = std::exchange(rhs._opt, Opt{});
-    _vacantSubPools = std::exchange(rhs._vacantSubPools, std::numeric_limits<USize>::max());
-    _subPoolsWhichHaveAtLeastOneElement = std::exchange(rhs._subPoolsWhichHaveAtLeastOneElement, 0);
+    _vacantSubPools = std::exchange(rhs._vacantSubPools, MakeSubPoolsMaskFull());
+    _subPoolsWhichHaveAtLeastOneElement = std::exchange(rhs._subPoolsWhichHaveAtLeastOneElement, SubPoolsMask{});
     _subPoolToDeallocate = std::exchange(rhs._subPoolToDeallocate, SUB_POOL_ID_NONE);
+
+    // Differs from the previous generations of both pools
+    _generation = std::max(_generation, rhs._generation) + 1;
+    rhs._generation += 1;
+
     _pSubPools = std::exchange(rhs._pSubPools, nullptr);
+    _deferredDeallocations = std::exchange(rhs._deferredDeallocations, std::vector<DeferredDeallocation>{});
+    _layout = std::exchange(rhs._layout, MakeLayout(Opt{}));
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+    _instrumentation = std::exchange(rhs._instrumentation, KoPoolInstrumentation{});
+#endif
 
     return *this;
 }
 
 bool KoPoolIteratable::IsEmpty() const noexcept {
-    return _subPoolsWhichHaveAtLeastOneElement == 0;
+    return IsSubPoolsMaskEmpty(_subPoolsWhichHaveAtLeastOneElement);
+}
+
+const KoPoolIteratable::Opt& KoPoolIteratable::GetOpt() const noexcept {
+    return _opt;
+}
+
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+
+const KoPoolInstrumentation& KoPoolIteratable::GetInstrumentation() const noexcept {
+    return _instrumentation;
+}
+
+void KoPoolIteratable::ResetInstrumentation() noexcept {
+    _instrumentation.Reset();
+}
+
+void KoPoolInstrumentation::Record(const Event event, const uint64_t ticks) noexcept {
+
+    Histogram& histogram = _histograms[event];
+
+    // log2, 0 ticks are in the first bucket
+    const size_t bucketID = ticks != 0 ? 63 - static_cast<size_t>(KoPoolIteratable::Count0BitsLeft(ticks)) : 0;
+
+    histogram.buckets[bucketID] += 1;
+    histogram.cnt += 1;
+    histogram.totalTicks += ticks;
+    histogram.maxTicks = ticks > histogram.maxTicks ? ticks : histogram.maxTicks;
+}
+#endif
+
+KoPoolIteratable::USize KoPoolIteratable::Size() const noexcept {
+
+    USize size = 0;
+
+    // The allocation path updates only the counter of the sub pool
+    USize subPoolID = FindSubPoolsMaskBit(_subPoolsWhichHaveAtLeastOneElement, 0);
+    while (subPoolID != SUB_POOL_ID_NONE) {
+
+        size += _pSubPools->pools[subPoolID].numUsed;
+        subPoolID = FindSubPoolsMaskBit(_subPoolsWhichHaveAtLeastOneElement, subPoolID + 1);
+    }
+
+    return size;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetGeneration() const noexcept {
+    return _generation;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::Capacity() const noexcept {
+    return _pSubPools ? _pSubPools->capacity : 0;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::BytesReserved() const noexcept {
+    return _pSubPools ? _pSubPools->numBytesReserved : 0;
+}
+
+KoPoolIteratable::Stats KoPoolIteratable::GetStats() const {
+
+    StatsCursor cursor{};
+    while (!CollectStats(cursor, std::numeric_limits<USize>::max())) {}
+
+    return std::move(cursor.stats);
+}
+
+bool KoPoolIteratable::CollectStats(StatsCursor& cursor, const USize maxWords) const {
+
+    if (!cursor.isStarted) {
+
+        cursor = StatsCursor{};
+        cursor.isStarted = true;
+    }
+
+    Stats& stats = cursor.stats;
+
+    const auto addFreeRun = [&stats](SubPoolStats& subPoolStats, const USize freeRunLength) {
+
+        subPoolStats.numFreeRuns += 1;
+        subPoolStats.freeRunsHistogram[Log2(freeRunLength)] += 1;
+
+        stats.numFreeRuns += 1;
+        stats.freeRunsHistogram[Log2(freeRunLength)] += 1;
+    };
+
+    USize numWords = 0;
+
+    for (; cursor.subPoolID < static_cast<USize>(SUBPOOLS_CNT - 1); ++cursor.subPoolID) {
+
+        const USize subPoolID = cursor.subPoolID;
+
+        // The sub pool can be deallocated between calls
+        if (!_pSubPools || !_pSubPools->pointers[subPoolID]) {
+
+            cursor.isSubPoolStarted = false;
+            continue;
+        }
+
+        const USize size = GetSubPoolSize(_layout, subPoolID);
+        const USize* pSkipBitmap = _pSubPools->pools[subPoolID].pSkipBitmap;
+
+        if (!cursor.isSubPoolStarted) {
+
+            SubPoolStats subPoolStats{};
+            subPoolStats.subPoolID = subPoolID;
+            subPoolStats.numSlots = size;
+            subPoolStats.numUsed = _pSubPools->pools[subPoolID].numUsed;
+            subPoolStats.dataSizeInBytes = size * _layout.slotSizeInBytes;
+            subPoolStats.skipBitmapSizeInBytes = GetSkipBitmapSizeInBytes(_layout, subPoolID);
+            subPoolStats.isPendingRelease = _subPoolToDeallocate == subPoolID;
+
+            stats.subPools.push_back(subPoolStats);
+
+            stats.numSlots += subPoolStats.numSlots;
+            stats.numUsed += subPoolStats.numUsed;
+            stats.dataSizeInBytes += subPoolStats.dataSizeInBytes;
+            stats.skipBitmapSizeInBytes += subPoolStats.skipBitmapSizeInBytes;
+
+            cursor.isSubPoolStarted = true;
+            cursor.wordID = 0;
+            cursor.freeRunLength = 0;
+        }
+
+        SubPoolStats& subPoolStats = stats.subPools.back();
+
+        const USize numSubPoolWords = CeilDiv(size, DIGITS);
+        for (; cursor.wordID < numSubPoolWords; ++cursor.wordID) {
+
+            if (numWords == maxWords) {
+                return false;
+            }
+
+            numWords += 1;
+
+            // Bits after the sub pool size are set in 'ResetSubPool(...)'
+            const USize numBits = std::min(size - cursor.wordID * DIGITS, DIGITS);
+            const USize word = pSkipBitmap[cursor.wordID];
+
+            // 1 - vacant element (skip list node), each iteration consumes a run of equal bits
+            USize bitID = 0;
+            while (bitID < numBits) {
+
+                const bool isVacant = ((word >> bitID) & 0b1) == 1;
+
+                const USize runLength = std::min(
+                    static_cast<USize>(Count0BitsRight(isVacant ? ~(word >> bitID) : (word >> bitID))),
+                    numBits - bitID
+                );
+
+                bitID += runLength;
+
+                if (isVacant) {
+
+                    cursor.freeRunLength += runLength;
+                }
+                else if (cursor.freeRunLength > 0) {
+
+                    addFreeRun(subPoolStats, cursor.freeRunLength);
+                    cursor.freeRunLength = 0;
+                }
+            }
+        }
+
+        if (cursor.freeRunLength > 0) {
+
+            addFreeRun(subPoolStats, cursor.freeRunLength);
+            cursor.freeRunLength = 0;
+        }
+
+        cursor.isSubPoolStarted = false;
+    }
+
+    stats.metadataSizeInBytes = _pSubPools ? sizeof(SubPools) : 0;
+    cursor.isStarted = false;
+
+    return true;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSubPoolNumUsed(const USize subPoolID) const noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(subPoolID < SUBPOOLS_CNT - 1);
+    return _pSubPools ? _pSubPools->pools[subPoolID].numUsed : 0;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSubPoolCapacity(const USize subPoolID) const noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(subPoolID < SUBPOOLS_CNT - 1);
+    return _pSubPools && _pSubPools->pointers[subPoolID] ? GetSubPoolSize(_layout, subPoolID) : 0;
 }
 
 KoPoolIteratable::AllocBytesResult KoPoolIteratable::AllocateBytes() noexcept {
 
+    __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(_instrumentation, AllocateBytes);
+
     if (!_pSubPools) {
 
-        SubPools* pSubPools = reinterpret_cast<SubPools*>(AlignedMalloc(sizeof(SubPools), alignof(SubPools)));
+        SubPools* pSubPools = reinterpret_cast<SubPools*>(
+            AllocateMetadata(_opt.metadataAllocator, sizeof(SubPools), alignof(SubPools), SUB_POOL_ID_NONE)
+        );
+
         if (!pSubPools) {
             return AllocBytesResult{};
         }
 
         new (pSubPools) SubPools{};
+        pSubPools->opt = _opt;
+        pSubPools->layout = _layout;
+        pSubPools->numBytesReserved = sizeof(SubPools);
 
         _pSubPools = SubPoolsUniquePtr{ pSubPools };
     }
 
-    if (_vacantSubPools == 0) {
+    const USize subPoolID = FindSubPoolsMaskBit(_vacantSubPools, 0);
+
+    // All sub pools are full, the last bit of '_vacantSubPools' isn't a sub pool
+    if (subPoolID >= SUBPOOLS_CNT - 1) {
         return AllocBytesResult{};
     }
 
-    const USize subPoolID = Count0BitsRight(_vacantSubPools);
-
-    // overflow (>= 2^DIGITS)
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPoolID < DIGITS);
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
 
-    const USize size = GetSubPoolSize(subPoolID);
+    const USize size = GetSubPoolSize(_layout, subPoolID);
 
     if (!_pSubPools->pointers[subPoolID]) {
 
-        _pSubPools->pointers[subPoolID] = reinterpret_cast<uint8_t*>(
-            AlignedMalloc(size * _opt.elementSizeInBytes, _opt.elementAlignment)
-        );
+        __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(_instrumentation, SubPoolGrow);
 
-        if (!_pSubPools->pointers[subPoolID]) {
+        uint8_t* pBlock = AllocateSubPoolMemory(*_pSubPools, subPoolID);
+
+        if (!pBlock) {
             return AllocBytesResult{};
         }
 
-        _pSubPools->pools[subPoolID].pPrevFreeSkipNodeTail = reinterpret_cast<SkipNodeTail*>(
-            AlignedMalloc(CeilDiv(size, DIGITS) * sizeof(USize), alignof(USize))
-        );
+        _pSubPools->pointers[subPoolID] = pBlock + GetSkipBitmapOffsetInBytes(*_pSubPools, subPoolID);
 
-        if (!_pSubPools->pools[subPoolID].pPrevFreeSkipNodeTail) {
+        _pSubPools->pools[subPoolID].pSkipBitmap = reinterpret_cast<USize*>(
+            _opt.isSkipBitmapColocated
+                ? pBlock
+                : AllocateMetadata(_opt.metadataAllocator, GetSkipBitmapSizeInBytes(_layout, subPoolID), alignof(USize), subPoolID)
+        );
 
-            AlignedFree(_pSubPools->pointers[subPoolID]);
-            _pSubPools->pointers[subPoolID] = nullptr;
+        if (!_pSubPools->pools[subPoolID].pSkipBitmap) {
 
+            DeallocateSubPoolMemory(*_pSubPools, subPoolID);
             return AllocBytesResult{};
         }
 
         ResetSubPool(subPoolID);
         InsertSortedPointer(subPoolID);
+
+        _pSubPools->capacity += size;
+        _pSubPools->numBytesReserved += GetSubPoolReservedBytes(*_pSubPools, subPoolID);
+
+        _generation += 1;
     }
 
     SubPools::Pool& subPool = _pSubPools->pools[subPoolID];
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
     subPool.numUsed += 1;
-#endif
 
     if (_subPoolToDeallocate == subPoolID) {
         _subPoolToDeallocate = SUB_POOL_ID_NONE;
     }
 
-    _subPoolsWhichHaveAtLeastOneElement |= (static_cast<USize>(1) << subPoolID);
+    SetSubPoolsMaskBit(_subPoolsWhichHaveAtLeastOneElement, subPoolID);
+
+    uint8_t* pMemory = reinterpret_cast<uint8_t*>(GetNextFreeSkipNodeHead(&subPool, subPoolID));
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(pMemory);
 
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPool.pNextFreeSkipNodeHead);
-    uint8_t* pMemory = reinterpret_cast<uint8_t*>(subPool.pNextFreeSkipNodeHead);
+    AllocBytesResult result{};
+    result.subPoolID = subPoolID;
+    result.pMemory = pMemory;
+    result.id = GetSubPoolBaseID(_layout, subPoolID) + PtrToIDInSubPool(pMemory, subPoolID);
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(IsSkipListNode(pMemory, subPoolID));
     defer{ SetIsSkipListNode(pMemory, subPoolID, false); };
@@ -172,47 +463,38 @@ KoPoolIteratable::AllocBytesResult KoPoolIteratable::AllocateBytes() noexcept {
     if (!IsRightSkipListNodeSafe(pMemory, subPoolID)) {
 
         const SkipNodeTail* pMemoryTail = reinterpret_cast<SkipNodeTail*>(pMemory);
-        __KO_POOL_ITERATABLE_ASSERT_TEST__(pMemoryTail->pPrevFreeSkipNodeTail == &subPool);
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(GetPrevFreeSkipNodeTail(pMemoryTail, subPoolID) == &subPool);
 
-        subPool.pNextFreeSkipNodeHead = pMemoryTail->pNextFreeSkipNodeHead;
+        SkipNodeBase* pNextHead = GetNextFreeSkipNodeHead(pMemoryTail, subPoolID);
+        SetNextFreeSkipNodeHead(&subPool, pNextHead, subPoolID);
 
-        HeadNodeSetPrevFreeSkipNodeTail(pMemoryTail->pNextFreeSkipNodeHead, &subPool, subPoolID);
+        HeadNodeSetPrevFreeSkipNodeTail(pNextHead, &subPool, subPoolID);
 
-        if (!pMemoryTail->pNextFreeSkipNodeHead) {
+        if (!pNextHead) {
 
-            _vacantSubPools &= ~(static_cast<USize>(1) << subPoolID);
+            ResetSubPoolsMaskBit(_vacantSubPools, subPoolID);
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
             __KO_POOL_ITERATABLE_ASSERT_DEV__(subPool.numUsed == size);
-#endif
         }
 
-        AllocBytesResult result{};
-        result.subPoolID = subPoolID;
-        result.pMemory = pMemory;
-
         return result;
     }
 
     const SkipNodeHead* pMemoryHead = reinterpret_cast<SkipNodeHead*>(pMemory);
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(pMemoryHead->pPrevFreeSkipNodeTail == &subPool);
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(GetPrevFreeSkipNodeTail(pMemoryHead, subPoolID) == &subPool);
 
     SkipNodeHead* pHead = reinterpret_cast<SkipNodeHead*>(pMemory + _opt.elementSizeInBytes);
     if (pMemoryHead->numBytesToTail != _opt.elementSizeInBytes) {
 
-        pHead->pPrevFreeSkipNodeTail = pMemoryHead->pPrevFreeSkipNodeTail;
-        pHead->numBytesToTail = pMemoryHead->numBytesToTail - _opt.elementSizeInBytes;
+        SetPrevFreeSkipNodeTail(pHead, GetPrevFreeSkipNodeTail(pMemoryHead, subPoolID), subPoolID);
+        pHead->numBytesToTail = static_cast<SkipNodeSize>(pMemoryHead->numBytesToTail - _opt.elementSizeInBytes);
     }
     else {
 
         __KO_POOL_ITERATABLE_ASSERT_TEST__(!IsRightSkipListNodeSafe(pMemory + _opt.elementSizeInBytes, subPoolID));
     }
 
-    subPool.pNextFreeSkipNodeHead = pHead;
-
-    AllocBytesResult result{};
-    result.subPoolID = subPoolID;
-    result.pMemory = pMemory;
+    SetNextFreeSkipNodeHead(&subPool, pHead, subPoolID);
 
     return result;
 }
@@ -225,44 +507,22 @@ void KoPoolIteratable::DeallocateBytesImpl(void* pMemory_, const USize subPoolID
         return;
     }
 
+    // Declared before 'defer', so the sub pool release is measured too
+    __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(_instrumentation, DeallocateBytes);
+
     __KO_POOL_ITERATABLE_ASSERT_TEST__(!IsEmpty());
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
     _pSubPools->pools[subPoolID].numUsed -= 1;
-#endif
 
-    _vacantSubPools |= (static_cast<USize>(1) << subPoolID);
+    SetSubPoolsMaskBit(_vacantSubPools, subPoolID);
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(!IsSkipListNode(pMemory, subPoolID));
 
     defer{
 
         SetIsSkipListNode(pMemory, subPoolID, true);
-
-        if (IsSubPoolEmpty(subPoolID)) {
-
-            _subPoolsWhichHaveAtLeastOneElement &= ~(static_cast<USize>(1) << subPoolID);
-
-            if (_subPoolToDeallocate == SUB_POOL_ID_NONE) {
-                _subPoolToDeallocate = subPoolID;
-            }
-            else {
-
-                if (subPoolID < _subPoolToDeallocate) {
-
-                    RemoveSortedPointer(_subPoolToDeallocate);
-                    DeallocateSubPoolMemory(*_pSubPools, _subPoolToDeallocate);
-
-                    _subPoolToDeallocate = subPoolID;
-                }
-                else {
-
-                    RemoveSortedPointer(subPoolID);
-                    DeallocateSubPoolMemory(*_pSubPools, subPoolID);
-                }
-            }
-        }
+        ReleaseSubPoolIfEmpty(subPoolID);
     };
 
     const bool isLeftSkipListNode = IsLeftSkipListNodeSafe(pMemory, subPoolID);
@@ -271,37 +531,44 @@ void KoPoolIteratable::DeallocateBytesImpl(void* pMemory_, const USize subPoolID
     if (isLeftSkipListNode && isRightSkipListNode) {
 
         SkipNodeTail* pTailLeft = reinterpret_cast<SkipNodeTail*>(pMemory - _opt.elementSizeInBytes);
-        __KO_POOL_ITERATABLE_ASSERT_TEST__(pTailLeft->pPrevFreeSkipNodeTail);
+        SkipNodeTail* pTailLeftPrev = GetPrevFreeSkipNodeTail(pTailLeft, subPoolID);
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(pTailLeftPrev);
 
         const bool isNextLeftSkipNode = IsLeftSkipListNodeSafe(pMemory - _opt.elementSizeInBytes, subPoolID);
 
         SkipNodeHead* pHeadLeft = isNextLeftSkipNode
-            ? TailToHead(pTailLeft)
+            ? TailToHead(pTailLeft, subPoolID)
             : reinterpret_cast<SkipNodeHead*>(pTailLeft);
 
-        __KO_POOL_ITERATABLE_ASSERT_TEST__(pHeadLeft->pPrevFreeSkipNodeTail);
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(GetPrevFreeSkipNodeTail(pHeadLeft, subPoolID));
 
         SkipNodeBase* pRightBase = reinterpret_cast<SkipNodeBase*>(pMemory + _opt.elementSizeInBytes);
-        __KO_POOL_ITERATABLE_ASSERT_TEST__(pRightBase->pPrevFreeSkipNodeTail);
+        SkipNodeTail* pRightPrev = GetPrevFreeSkipNodeTail(pRightBase, subPoolID);
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(pRightPrev);
 
         const uintmax_t numBytesToTailRight = IsRightSkipListNodeSafe(pMemory + _opt.elementSizeInBytes, subPoolID)
             ? static_cast<SkipNodeHead*>(pRightBase)->numBytesToTail
             : 0;
 
-        HeadNodeSetPrevFreeSkipNodeTail(pTailLeft->pNextFreeSkipNodeHead, pTailLeft->pPrevFreeSkipNodeTail, subPoolID);
-        pTailLeft->pPrevFreeSkipNodeTail->pNextFreeSkipNodeHead = pTailLeft->pNextFreeSkipNodeHead;
+        SkipNodeBase* pTailLeftNext = GetNextFreeSkipNodeHead(pTailLeft, subPoolID);
+
+        HeadNodeSetPrevFreeSkipNodeTail(pTailLeftNext, pTailLeftPrev, subPoolID);
+        SetNextFreeSkipNodeHead(pTailLeftPrev, pTailLeftNext, subPoolID);
 
-        pTailLeft->pPrevFreeSkipNodeTail = pRightBase->pPrevFreeSkipNodeTail;
-        pRightBase->pPrevFreeSkipNodeTail->pNextFreeSkipNodeHead = pHeadLeft;
+        // 'HeadNodeSetPrevFreeSkipNodeTail(...)' could change the previous of the right run
+        pRightPrev = GetPrevFreeSkipNodeTail(pRightBase, subPoolID);
+
+        SetPrevFreeSkipNodeTail(pTailLeft, pRightPrev, subPoolID);
+        SetNextFreeSkipNodeHead(pRightPrev, pHeadLeft, subPoolID);
 
         if (isNextLeftSkipNode) {
 
-            pHeadLeft->pPrevFreeSkipNodeTail = pRightBase->pPrevFreeSkipNodeTail;
-            pHeadLeft->numBytesToTail += _opt.elementSizeInBytes * 2 + numBytesToTailRight;
+            SetPrevFreeSkipNodeTail(pHeadLeft, pRightPrev, subPoolID);
+            pHeadLeft->numBytesToTail += static_cast<SkipNodeSize>(_opt.elementSizeInBytes * 2 + numBytesToTailRight);
         }
         else {
 
-            pHeadLeft->numBytesToTail = _opt.elementSizeInBytes * 2 + numBytesToTailRight;
+            pHeadLeft->numBytesToTail = static_cast<SkipNodeSize>(_opt.elementSizeInBytes * 2 + numBytesToTailRight);
         }
 
         return;
@@ -312,21 +579,21 @@ void KoPoolIteratable::DeallocateBytesImpl(void* pMemory_, const USize subPoolID
         SkipNodeTail* pTailOld = reinterpret_cast<SkipNodeTail*>(pMemory - _opt.elementSizeInBytes);
 
         SkipNodeTail* pTailNew = reinterpret_cast<SkipNodeTail*>(pMemory);
-        pTailNew->pPrevFreeSkipNodeTail = pTailOld->pPrevFreeSkipNodeTail;
-        pTailNew->pNextFreeSkipNodeHead = pTailOld->pNextFreeSkipNodeHead;
+        SetPrevFreeSkipNodeTail(pTailNew, GetPrevFreeSkipNodeTail(pTailOld, subPoolID), subPoolID);
+        SetNextFreeSkipNodeHead(pTailNew, GetNextFreeSkipNodeHead(pTailOld, subPoolID), subPoolID);
 
         if (IsLeftSkipListNodeSafe(pMemory - _opt.elementSizeInBytes, subPoolID)) {
 
-            SkipNodeHead* pHead = TailToHead(pTailOld);
-            pHead->numBytesToTail += _opt.elementSizeInBytes;
+            SkipNodeHead* pHead = TailToHead(pTailOld, subPoolID);
+            pHead->numBytesToTail += static_cast<SkipNodeSize>(_opt.elementSizeInBytes);
         }
         else {
 
             SkipNodeHead* pHead = reinterpret_cast<SkipNodeHead*>(pTailOld);
-            pHead->numBytesToTail = _opt.elementSizeInBytes;
+            pHead->numBytesToTail = static_cast<SkipNodeSize>(_opt.elementSizeInBytes);
         }
 
-        HeadNodeSetPrevFreeSkipNodeTail(pTailNew->pNextFreeSkipNodeHead, pTailNew, subPoolID);
+        HeadNodeSetPrevFreeSkipNodeTail(GetNextFreeSkipNodeHead(pTailNew, subPoolID), pTailNew, subPoolID);
 
         return;
     }
@@ -336,8 +603,8 @@ void KoPoolIteratable::DeallocateBytesImpl(void* pMemory_, const USize subPoolID
         const SkipNodeBase* pNodeOld = reinterpret_cast<SkipNodeBase*>(pMemory + _opt.elementSizeInBytes);
 
         SkipNodeHead* pHeadNew = reinterpret_cast<SkipNodeHead*>(pMemory);
-        pHeadNew->pPrevFreeSkipNodeTail = pNodeOld->pPrevFreeSkipNodeTail;
-        pHeadNew->numBytesToTail = _opt.elementSizeInBytes;
+        SetPrevFreeSkipNodeTail(pHeadNew, GetPrevFreeSkipNodeTail(pNodeOld, subPoolID), subPoolID);
+        pHeadNew->numBytesToTail = static_cast<SkipNodeSize>(_opt.elementSizeInBytes);
 
         if (IsRightSkipListNodeSafe(pMemory + _opt.elementSizeInBytes, subPoolID)) {
 
@@ -345,7 +612,7 @@ void KoPoolIteratable::DeallocateBytesImpl(void* pMemory_, const USize subPoolID
             pHeadNew->numBytesToTail += pHeadOld->numBytesToTail;
         }
 
-        pHeadNew->pPrevFreeSkipNodeTail->pNextFreeSkipNodeHead = pHeadNew;
+        SetNextFreeSkipNodeHead(GetPrevFreeSkipNodeTail(pHeadNew, subPoolID), pHeadNew, subPoolID);
 
         return;
     }
@@ -353,11 +620,163 @@ void KoPoolIteratable::DeallocateBytesImpl(void* pMemory_, const USize subPoolID
     SubPools::Pool& subPool = _pSubPools->pools[subPoolID];
 
     SkipNodeTail* pTail = reinterpret_cast<SkipNodeTail*>(pMemory);
-    pTail->pPrevFreeSkipNodeTail = &subPool;
-    pTail->pNextFreeSkipNodeHead = subPool.pNextFreeSkipNodeHead;
+    SetPrevFreeSkipNodeTail(pTail, &subPool, subPoolID);
+    SetNextFreeSkipNodeHead(pTail, GetNextFreeSkipNodeHead(&subPool, subPoolID), subPoolID);
+
+    SetNextFreeSkipNodeHead(&subPool, pTail, subPoolID);
+    HeadNodeSetPrevFreeSkipNodeTail(GetNextFreeSkipNodeHead(pTail, subPoolID), pTail, subPoolID);
+}
+
+void KoPoolIteratable::DeallocateBytesRange(const USize firstID, const USize lastID) noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(firstID <= lastID);
+
+    USize id = firstID;
+    for (;;) {
+
+        const USize subPoolID = IDToSubPoolIDImpl(id);
+        const USize baseID = GetSubPoolBaseID(_layout, subPoolID);
+        const USize lastIDInSubPool = baseID + GetSubPoolSize(_layout, subPoolID) - 1;
+
+        const USize rangeLastID = std::min(lastID, lastIDInSubPool);
+        DeallocateBytesRangeInSubPool(subPoolID, id - baseID, rangeLastID - baseID);
+
+        if (rangeLastID == lastID) {
+            return;
+        }
+
+        id = rangeLastID + 1;
+    }
+}
+
+void KoPoolIteratable::DeallocateBytesRangeInSubPool(
+    const USize subPoolID, const USize idInSubPoolBegin, const USize idInSubPoolEnd
+) noexcept {
+
+    __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(_instrumentation, DeallocateBytes);
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(_pSubPools->pointers[subPoolID]);
+
+    SubPools::Pool& subPool = _pSubPools->pools[subPoolID];
+
+    const USize numElements = idInSubPoolEnd - idInSubPoolBegin + 1;
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(idInSubPoolEnd < GetSubPoolSize(_layout, subPoolID));
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(numElements <= subPool.numUsed);
+
+    subPool.numUsed -= numElements;
+
+    SetSubPoolsMaskBit(_vacantSubPools, subPoolID);
+
+    uint8_t* pSubPool = _pSubPools->pointers[subPoolID];
+    const USize elementSizeInBytes = _opt.elementSizeInBytes;
+
+    uint8_t* pBegin = pSubPool + idInSubPoolBegin * elementSizeInBytes;
+    uint8_t* pEnd = pSubPool + idInSubPoolEnd * elementSizeInBytes;
+
+    // The range is merged with the free runs on both sides into one run ['pRunHead', 'pRunTail'],
+    // the neighbour runs are unlinked before the skip bits of the range are set
+    uint8_t* pRunHead = pBegin;
+    uint8_t* pRunTail = pEnd;
+
+    if (IsLeftSkipListNodeSafe(pBegin, subPoolID)) {
+
+        SkipNodeTail* pTailLeft = reinterpret_cast<SkipNodeTail*>(pBegin - elementSizeInBytes);
+
+        pRunHead = IsLeftSkipListNodeSafe(pTailLeft, subPoolID)
+            ? reinterpret_cast<uint8_t*>(TailToHead(pTailLeft, subPoolID))
+            : reinterpret_cast<uint8_t*>(pTailLeft);
+
+        SkipNodeTail* pTailLeftPrev = GetPrevFreeSkipNodeTail(pTailLeft, subPoolID);
+        SkipNodeBase* pTailLeftNext = GetNextFreeSkipNodeHead(pTailLeft, subPoolID);
+
+        SetNextFreeSkipNodeHead(pTailLeftPrev, pTailLeftNext, subPoolID);
+        HeadNodeSetPrevFreeSkipNodeTail(pTailLeftNext, pTailLeftPrev, subPoolID);
+    }
+
+    if (IsRightSkipListNodeSafe(pEnd, subPoolID)) {
+
+        SkipNodeBase* pHeadRight = reinterpret_cast<SkipNodeBase*>(pEnd + elementSizeInBytes);
+
+        SkipNodeTail* pTailRight = IsRightSkipListNodeSafe(pHeadRight, subPoolID)
+            ? reinterpret_cast<SkipNodeTail*>(
+                reinterpret_cast<uint8_t*>(pHeadRight) + static_cast<SkipNodeHead*>(pHeadRight)->numBytesToTail
+            )
+            : static_cast<SkipNodeTail*>(pHeadRight);
+
+        pRunTail = reinterpret_cast<uint8_t*>(pTailRight);
 
-    subPool.pNextFreeSkipNodeHead = pTail;
-    HeadNodeSetPrevFreeSkipNodeTail(pTail->pNextFreeSkipNodeHead, pTail, subPoolID);
+        // Read after the left run is unlinked, it can be the previous of the right run
+        SkipNodeTail* pTailRightPrev = GetPrevFreeSkipNodeTail(pTailRight, subPoolID);
+        SkipNodeBase* pTailRightNext = GetNextFreeSkipNodeHead(pTailRight, subPoolID);
+
+        SetNextFreeSkipNodeHead(pTailRightPrev, pTailRightNext, subPoolID);
+        HeadNodeSetPrevFreeSkipNodeTail(pTailRightNext, pTailRightPrev, subPoolID);
+    }
+
+    // The skip bits of the range, a word at a time
+    for (USize idInSubPool = idInSubPoolBegin; idInSubPool <= idInSubPoolEnd;) {
+
+        const USize bitID = idInSubPool & (DIGITS - 1);
+        const USize numBits = std::min(DIGITS - bitID, idInSubPoolEnd - idInSubPool + 1);
+
+        const USize mask = numBits == DIGITS
+            ? std::numeric_limits<USize>::max()
+            : ((static_cast<USize>(1) << numBits) - 1) << bitID;
+
+        // Every element of the range must be allocated
+        __KO_POOL_ITERATABLE_ASSERT_DEV__((subPool.pSkipBitmap[idInSubPool / DIGITS] & mask) == 0);
+
+        subPool.pSkipBitmap[idInSubPool / DIGITS] |= mask;
+        idInSubPool += numBits;
+    }
+
+    // The merged run is linked first, like a deallocated element without free neighbours
+    SkipNodeBase* pFirstHead = GetNextFreeSkipNodeHead(&subPool, subPoolID);
+    SkipNodeTail* pTail = reinterpret_cast<SkipNodeTail*>(pRunTail);
+
+    if (pRunHead != pRunTail) {
+
+        SkipNodeHead* pHead = reinterpret_cast<SkipNodeHead*>(pRunHead);
+        SetPrevFreeSkipNodeTail(pHead, &subPool, subPoolID);
+        pHead->numBytesToTail = static_cast<SkipNodeSize>(pRunTail - pRunHead);
+    }
+
+    SetPrevFreeSkipNodeTail(pTail, &subPool, subPoolID);
+    SetNextFreeSkipNodeHead(pTail, pFirstHead, subPoolID);
+
+    SetNextFreeSkipNodeHead(&subPool, reinterpret_cast<SkipNodeBase*>(pRunHead), subPoolID);
+    HeadNodeSetPrevFreeSkipNodeTail(pFirstHead, pTail, subPoolID);
+
+    ReleaseSubPoolIfEmpty(subPoolID);
+}
+
+void KoPoolIteratable::ReleaseSubPoolIfEmpty(const USize subPoolID) noexcept {
+
+    if (!IsSubPoolEmpty(subPoolID)) {
+        return;
+    }
+
+    ResetSubPoolsMaskBit(_subPoolsWhichHaveAtLeastOneElement, subPoolID);
+
+    if (_subPoolToDeallocate == SUB_POOL_ID_NONE) {
+
+        _subPoolToDeallocate = subPoolID;
+        return;
+    }
+
+    __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(_instrumentation, SubPoolRelease);
+
+    if (subPoolID < _subPoolToDeallocate) {
+
+        ReleaseSubPool(_subPoolToDeallocate);
+        _subPoolToDeallocate = subPoolID;
+    }
+    else {
+
+        ReleaseSubPool(subPoolID);
+    }
 }
 
 void KoPoolIteratable::DeallocateBytesByPtr(void* pMemory_) noexcept {
@@ -368,7 +787,8 @@ void KoPoolIteratable::DeallocateBytesByPtr(void* pMemory_) noexcept {
         return;
     }
 
-    const USize subPoolID = FindSubPoolIDByPtrImpl(pMemory);
+    // Instrumented, unlike the searches of the asserts
+    const USize subPoolID = FindSubPoolIDByPtr(pMemory);
     return DeallocateBytesImpl(pMemory, subPoolID);
 }
 
@@ -392,15 +812,192 @@ void KoPoolIteratable::DeallocateBytesAll() noexcept {
 
     for (USize i = 0; i < static_cast<USize>(_pSubPools->pointers.size()); ++i) {
 
+        DestroySubPoolElements(*_pSubPools, i);
+
+        _pSubPools->pools[i].numUsed = 0;
         DeallocateSubPoolMemory(*_pSubPools, i);
     }
 
-    _vacantSubPools = std::numeric_limits<USize>::max();
-    _subPoolsWhichHaveAtLeastOneElement = 0;
+    _generation += 1;
+
+    _vacantSubPools = MakeSubPoolsMaskFull();
+    _subPoolsWhichHaveAtLeastOneElement = SubPoolsMask{};
     _subPoolToDeallocate = SUB_POOL_ID_NONE;
 
     _pSubPools->sortedPointersSize = 0;
-    _pSubPools->sortedPointers = { SortedPointer{} };
+    _pSubPools->sortedPointers = { nullptr };
+
+    // Freed with all elements
+    _deferredDeallocations.clear();
+}
+
+void KoPoolIteratable::Reset() noexcept {
+
+    _deferredDeallocations.clear();
+
+    if (!_pSubPools) {
+        return;
+    }
+
+    for (USize i = 0; i < static_cast<USize>(_pSubPools->pointers.size()); ++i) {
+
+        if (!_pSubPools->pointers[i] || _pSubPools->pools[i].numUsed == 0) {
+            continue;
+        }
+
+        DestroySubPoolElements(*_pSubPools, i);
+
+        _pSubPools->pools[i].numUsed = 0;
+        ResetSubPool(i);
+    }
+
+    _generation += 1;
+
+    _vacantSubPools = MakeSubPoolsMaskFull();
+    _subPoolsWhichHaveAtLeastOneElement = SubPoolsMask{};
+}
+
+void KoPoolIteratable::DeallocateBytesLater(void* pMemory) {
+
+    if (!pMemory) {
+        return;
+    }
+
+    DeferredDeallocation deferred{};
+    deferred.pMemory = reinterpret_cast<uint8_t*>(pMemory);
+
+    _deferredDeallocations.push_back(deferred);
+}
+
+KoPoolIteratable::USize KoPoolIteratable::FlushDeferred() noexcept {
+
+    std::sort(
+        _deferredDeallocations.begin(), _deferredDeallocations.end(),
+        [](const DeferredDeallocation& lhs, const DeferredDeallocation& rhs) { return lhs.pMemory < rhs.pMemory; }
+    );
+
+    const USize numFreed = static_cast<USize>(_deferredDeallocations.size());
+
+    // The destructors run before the elements are freed, so none of them sees a skip node
+    for (const DeferredDeallocation& deferred : _deferredDeallocations) {
+        if (deferred.pDestroy) {
+            deferred.pDestroy(deferred.pMemory);
+        }
+    }
+
+    const USize elementSizeInBytes = _opt.elementSizeInBytes;
+
+    USize subPoolID = SUB_POOL_ID_NONE;
+
+    for (USize i = 0; i < numFreed;) {
+
+        uint8_t* pMemory = _deferredDeallocations[i].pMemory;
+
+        // Queued twice
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(i == 0 || _deferredDeallocations[i - 1].pMemory != pMemory);
+
+        // The sorted elements of a sub pool are contiguous, its pointer is non null while they are in the queue
+        if (subPoolID == SUB_POOL_ID_NONE || !IsPtrInsideSubPool(pMemory, subPoolID)) {
+            subPoolID = FindSubPoolIDByPtrImpl(pMemory);
+        }
+
+        // The run of the adjacent elements, it doesn't cross the sub pool end
+        const USize idInSubPoolBegin = PtrToIDInSubPool(pMemory, subPoolID);
+        const USize idInSubPoolLast = GetSubPoolSize(_layout, subPoolID) - 1;
+
+        USize idInSubPoolEnd = idInSubPoolBegin;
+        for (i += 1; i < numFreed && idInSubPoolEnd < idInSubPoolLast; ++i) {
+
+            if (_deferredDeallocations[i].pMemory != pMemory + (idInSubPoolEnd - idInSubPoolBegin + 1) * elementSizeInBytes) {
+                break;
+            }
+
+            idInSubPoolEnd += 1;
+        }
+
+        // Can release the sub pool, the next run then searches its sub pool again
+        DeallocateBytesRangeInSubPool(subPoolID, idInSubPoolBegin, idInSubPoolEnd);
+    }
+
+    _deferredDeallocations.clear();
+
+    return numFreed;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetNumDeferred() const noexcept {
+    return static_cast<USize>(_deferredDeallocations.size());
+}
+
+KoPoolIteratable::USize KoPoolIteratable::Trim() noexcept {
+
+    if (!_pSubPools) {
+        return 0;
+    }
+
+    USize numBytesTrimmed = 0;
+
+    if (_subPoolToDeallocate != SUB_POOL_ID_NONE) {
+
+        // Handed to 'Opt::subPoolReclaimer' it is freed later, by the reclaimer
+        if (!_opt.subPoolReclaimer.pReclaim) {
+            numBytesTrimmed += GetSubPoolReservedBytes(*_pSubPools, _subPoolToDeallocate);
+        }
+
+        ReleaseSubPool(_subPoolToDeallocate);
+        _subPoolToDeallocate = SUB_POOL_ID_NONE;
+    }
+
+    const uintptr_t pageSizeInBytes = GetPageSizeInBytes();
+
+    for (USize subPoolID = 0; subPoolID < static_cast<USize>(_pSubPools->pointers.size()); ++subPoolID) {
+
+        uint8_t* pSubPool = _pSubPools->pointers[subPoolID];
+        const USize size = GetSubPoolSize(_layout, subPoolID);
+
+        if (!pSubPool || !IsSubPoolPageMapped(_opt, GetSubPoolBlockSizeInBytes(*_pSubPools, subPoolID))) {
+            continue;
+        }
+
+        // Only heads and tails of the free runs store skip nodes, the elements between them can be discarded
+        SkipNodeBase* pNode = GetNextFreeSkipNodeHead(&_pSubPools->pools[subPoolID], subPoolID);
+        while (pNode) {
+
+            uint8_t* pHead = reinterpret_cast<uint8_t*>(pNode);
+
+            if (!IsRightSkipListNodeSafe(pHead, subPoolID)) {
+
+                pNode = GetNextFreeSkipNodeHead(reinterpret_cast<SkipNodeTail*>(pHead), subPoolID);
+                continue;
+            }
+
+            uint8_t* pTail = pHead + reinterpret_cast<SkipNodeHead*>(pHead)->numBytesToTail;
+            pNode = GetNextFreeSkipNodeHead(reinterpret_cast<SkipNodeTail*>(pTail), subPoolID);
+
+            const USize idInSubPoolBegin = PtrToIDInSubPool(pHead, subPoolID) + 1;
+            const USize idInSubPoolEnd = PtrToIDInSubPool(pTail, subPoolID);
+
+            for (USize columnID = 0; columnID < _opt.columnsCnt; ++columnID) {
+
+                uint8_t* pColumn = pSubPool + size * _layout.columnOffsetsInBytes[columnID];
+                const USize columnSizeInBytes = _layout.columnSizesInBytes[columnID];
+
+                const uintptr_t begin = RoundUp(
+                    reinterpret_cast<uintptr_t>(pColumn + idInSubPoolBegin * columnSizeInBytes), pageSizeInBytes
+                );
+
+                const uintptr_t end =
+                    reinterpret_cast<uintptr_t>(pColumn + idInSubPoolEnd * columnSizeInBytes) & ~(pageSizeInBytes - 1);
+
+                if (begin < end) {
+
+                    DiscardPages(reinterpret_cast<void*>(begin), end - begin);
+                    numBytesTrimmed += end - begin;
+                }
+            }
+        }
+    }
+
+    return numBytesTrimmed;
 }
 
 uint8_t* KoPoolIteratable::IDToPtr(const USize id) const noexcept {
@@ -416,6 +1013,8 @@ KoPoolIteratable::USize KoPoolIteratable::IDToSubPoolID(const USize id) const no
 
 KoPoolIteratable::USize KoPoolIteratable::FindSubPoolIDByPtr(const void* pMemory) const noexcept {
 
+    __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(_instrumentation, FindSortedPointerIDByPtr);
+
     const USize subPoolID = FindSubPoolIDByPtrImpl(pMemory);
     __KO_POOL_ITERATABLE_ASSERT_DEV__(subPoolID != SUB_POOL_ID_NONE);
     __KO_POOL_ITERATABLE_ASSERT_DEV__(IsPtrInsideSubPool(pMemory, subPoolID));
@@ -429,22 +1028,138 @@ KoPoolIteratable::USize KoPoolIteratable::PtrToID(const void* pMemory, const USi
     return poolID.id;
 }
 
-KoPoolIteratable::USize KoPoolIteratable::GetSubPoolSize(const USize subPoolID) noexcept {
-    return subPoolID == 0 ? 2 : static_cast<USize>(1) << subPoolID;
+uint8_t* KoPoolIteratable::GetColumnPtr(const void* pMemory, const USize subPoolID, const USize columnID) const noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(columnID < _opt.columnsCnt);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(IsPtrInsideSubPool(pMemory, subPoolID));
+
+    const USize idInSubPool = PtrToIDInSubPool(pMemory, subPoolID);
+
+    return
+        _pSubPools->pointers[subPoolID] +
+        GetSubPoolSize(_layout, subPoolID) * _layout.columnOffsetsInBytes[columnID] +
+        idInSubPool * _layout.columnSizesInBytes[columnID];
+}
+
+uint8_t* KoPoolIteratable::IDToColumnPtr(const USize id, const USize columnID) const noexcept {
+
+    const PoolID poolID = IDToPtrImpl(id);
+    return GetColumnPtr(poolID.pMemory, poolID.subPoolID, columnID);
+}
+
+KoPoolIteratable::Layout KoPoolIteratable::MakeLayout(const Opt& opt) noexcept {
+
+    Layout layout{};
+    layout.columnSizesInBytes[0] = opt.elementSizeInBytes;
+
+    USize offsetInBytes = opt.elementSizeInBytes;
+    for (USize i = 1; i < opt.columnsCnt; ++i) {
+
+        // The column array starts at 'GetSubPoolSize(...)' * 'offsetInBytes', so the aligned offset aligns the array
+        offsetInBytes = RoundUp(offsetInBytes, opt.columnAlignments[i]);
+
+        layout.columnOffsetsInBytes[i] = offsetInBytes;
+        layout.columnSizesInBytes[i] = opt.columnSizesInBytes[i];
+
+        offsetInBytes += opt.columnSizesInBytes[i];
+    }
+
+    layout.slotSizeInBytes = offsetInBytes;
+
+    layout.initialSubPoolSizeLog2 = std::max(Log2(opt.initialSubPoolSize), static_cast<USize>(1));
+    layout.growthFactorLog2 = std::max(Log2(opt.growthFactor), static_cast<USize>(1));
+
+    if (opt.maxSubPoolSize != 0) {
+        layout.maxSubPoolSizeLog2 = std::max(Log2(opt.maxSubPoolSize), static_cast<USize>(1));
+    }
+
+    layout.maxSubPoolSizeLog2 = std::max(layout.maxSubPoolSizeLog2, layout.initialSubPoolSizeLog2);
+
+#ifdef __KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__
+
+    // The skip node offsets address column 0 of the sub pool
+    while (layout.maxSubPoolSizeLog2 > 1 &&
+        (static_cast<USize>(1) << layout.maxSubPoolSizeLog2) * opt.elementSizeInBytes > COMPACT_SUB_POOL_SIZE_IN_BYTES_MAX
+    ) {
+        layout.maxSubPoolSizeLog2 -= 1;
+    }
+
+    layout.initialSubPoolSizeLog2 = std::min(layout.initialSubPoolSizeLog2, layout.maxSubPoolSizeLog2);
+#endif
+
+    // The first sub pool which starts at >= 2^c, it starts at 2^c, so the last growing sub pool may be smaller
+    layout.cappedSubPoolID = 1 + CeilDiv(layout.maxSubPoolSizeLog2 - layout.initialSubPoolSizeLog2, layout.growthFactorLog2);
+
+    return layout;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSkipBitmapSizeInBytes(const Layout& layout, const USize subPoolID) noexcept {
+    return CeilDiv(GetSubPoolSize(layout, subPoolID), DIGITS) * sizeof(USize);
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSubPoolReservedBytes(const SubPools& subPool, const USize subPoolID) noexcept {
+
+    if (subPool.opt.isSkipBitmapColocated) {
+        return GetSubPoolBlockSizeInBytes(subPool, subPoolID);
+    }
+
+    return GetSubPoolSize(subPool.layout, subPoolID) * subPool.layout.slotSizeInBytes + GetSkipBitmapSizeInBytes(subPool.layout, subPoolID);
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSkipBitmapOffsetInBytes(const SubPools& subPool, const USize subPoolID) noexcept {
+
+    if (!subPool.opt.isSkipBitmapColocated) {
+        return 0;
+    }
+
+    // The elements keep 'Opt::elementAlignment'
+    return RoundUp(GetSkipBitmapSizeInBytes(subPool.layout, subPoolID), subPool.opt.elementAlignment);
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSubPoolBlockSizeInBytes(const SubPools& subPool, const USize subPoolID) noexcept {
+    return GetSkipBitmapOffsetInBytes(subPool, subPoolID) + GetSubPoolSize(subPool.layout, subPoolID) * subPool.layout.slotSizeInBytes;
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSubPoolSize(const Layout& layout, const USize subPoolID) noexcept {
+
+    if (subPoolID >= layout.cappedSubPoolID) {
+        return static_cast<USize>(1) << layout.maxSubPoolSizeLog2;
+    }
+
+    return GetSubPoolBaseID(layout, subPoolID + 1) - GetSubPoolBaseID(layout, subPoolID);
+}
+
+KoPoolIteratable::USize KoPoolIteratable::GetSubPoolBaseID(const Layout& layout, const USize subPoolID) noexcept {
+
+    // in 2^0 we store 2^'initialSubPoolSizeLog2' elements
+    if (subPoolID == 0) {
+        return 0;
+    }
+
+    const USize maxSubPoolSizeLog2 = layout.maxSubPoolSizeLog2;
+    const USize cappedSubPoolID = layout.cappedSubPoolID;
+
+    if (subPoolID < cappedSubPoolID) {
+        return static_cast<USize>(1) << (layout.initialSubPoolSizeLog2 + layout.growthFactorLog2 * (subPoolID - 1));
+    }
+
+    // 2^c + (k - kc) * 2^c
+    return (subPoolID - cappedSubPoolID + 1) << maxSubPoolSizeLog2;
 }
 
 void KoPoolIteratable::InsertSortedPointer(const USize subPoolID) noexcept {
 
-    SortedPointer sortedPointer{};
-    sortedPointer.pMemory = _pSubPools->pointers[subPoolID];
-    sortedPointer.subPoolID = subPoolID;
+    std::array<uint8_t*, SUBPOOLS_CNT>& sortedPointers = _pSubPools->sortedPointers;
+    std::array<SubPoolIDSmall, SUBPOOLS_CNT>& sortedSubPoolIDs = _pSubPools->sortedSubPoolIDs;
 
-    _pSubPools->sortedPointers[_pSubPools->sortedPointersSize] = sortedPointer;
+    sortedPointers[_pSubPools->sortedPointersSize] = _pSubPools->pointers[subPoolID];
+    sortedSubPoolIDs[_pSubPools->sortedPointersSize] = static_cast<SubPoolIDSmall>(subPoolID);
 
     USize sortedInsertIdx = _pSubPools->sortedPointersSize;
-    while (sortedInsertIdx > 0 && _pSubPools->sortedPointers[sortedInsertIdx - 1].pMemory > _pSubPools->sortedPointers[sortedInsertIdx].pMemory) {
+    while (sortedInsertIdx > 0 && sortedPointers[sortedInsertIdx - 1] > sortedPointers[sortedInsertIdx]) {
 
-        std::swap(_pSubPools->sortedPointers[sortedInsertIdx - 1], _pSubPools->sortedPointers[sortedInsertIdx]);
+        std::swap(sortedPointers[sortedInsertIdx - 1], sortedPointers[sortedInsertIdx]);
+        std::swap(sortedSubPoolIDs[sortedInsertIdx - 1], sortedSubPoolIDs[sortedInsertIdx]);
         sortedInsertIdx -= 1;
     }
 
@@ -461,39 +1176,198 @@ void KoPoolIteratable::RemoveSortedPointer(const USize subPoolID) noexcept {
     while (idxToRemove + 1 < _pSubPools->sortedPointersSize) {
 
         _pSubPools->sortedPointers[idxToRemove] = _pSubPools->sortedPointers[idxToRemove + 1];
+        _pSubPools->sortedSubPoolIDs[idxToRemove] = _pSubPools->sortedSubPoolIDs[idxToRemove + 1];
         idxToRemove += 1;
     }
 
-    _pSubPools->sortedPointers[idxToRemove] = SortedPointer{};
+    _pSubPools->sortedPointers[idxToRemove] = nullptr;
+    _pSubPools->sortedSubPoolIDs[idxToRemove] = 0;
     _pSubPools->sortedPointersSize -= 1;
 }
 
+uint8_t* KoPoolIteratable::AllocateSubPoolMemory(const SubPools& subPool, const USize subPoolID) noexcept {
+
+    const Opt& opt = subPool.opt;
+    const USize sizeInBytes = GetSubPoolBlockSizeInBytes(subPool, subPoolID);
+
+    if (IsSubPoolPageMapped(opt, sizeInBytes)) {
+        return reinterpret_cast<uint8_t*>(MapPages(sizeInBytes));
+    }
+
+    if (opt.subPoolAllocator.pAllocate) {
+
+        return reinterpret_cast<uint8_t*>(opt.subPoolAllocator.pAllocate(
+            opt.subPoolAllocator.pUserData, sizeInBytes, opt.elementAlignment, subPoolID
+        ));
+    }
+
+    return reinterpret_cast<uint8_t*>(AlignedMalloc(sizeInBytes, opt.elementAlignment));
+}
+
 void KoPoolIteratable::DeallocateSubPoolMemory(SubPools& subPool, const USize subPoolID) noexcept {
 
-    AlignedFree(subPool.pointers[subPoolID]);
-    subPool.pointers[subPoolID] = nullptr;
+    FreeReleasedSubPool(DetachSubPoolMemory(subPool, subPoolID));
+}
+
+KoPoolIteratable::ReleasedSubPool KoPoolIteratable::DetachSubPoolMemory(SubPools& subPool, const USize subPoolID) noexcept {
 
-    AlignedFree(subPool.pools[subPoolID].pPrevFreeSkipNodeTail);
-    subPool.pools[subPoolID].pPrevFreeSkipNodeTail = nullptr;
+    // Only the fully allocated sub pool is counted, see 'AllocateBytes()'
+    if (subPool.pools[subPoolID].pSkipBitmap) {
 
-    subPool.pools[subPoolID].pNextFreeSkipNodeHead = nullptr;
+        subPool.capacity -= GetSubPoolSize(subPool.layout, subPoolID);
+        subPool.numBytesReserved -= GetSubPoolReservedBytes(subPool, subPoolID);
+    }
+
+    const bool isSkipBitmapColocated = subPool.opt.isSkipBitmapColocated;
+    uint8_t* pSubPool = subPool.pointers[subPoolID];
+
+    // With 'Opt::isSkipBitmapColocated' the block starts with the skip bit set and is freed as a whole
+    ReleasedSubPool releasedSubPool{};
+    releasedSubPool.pMemory = pSubPool ? pSubPool - GetSkipBitmapOffsetInBytes(subPool, subPoolID) : nullptr;
+    releasedSubPool.sizeInBytes = GetSubPoolBlockSizeInBytes(subPool, subPoolID);
+    releasedSubPool.alignment = subPool.opt.elementAlignment;
+    releasedSubPool.subPoolID = subPoolID;
+    releasedSubPool.pSkipBitmap = isSkipBitmapColocated ? nullptr : subPool.pools[subPoolID].pSkipBitmap;
+    releasedSubPool.skipBitmapSizeInBytes = GetSkipBitmapSizeInBytes(subPool.layout, subPoolID);
+    releasedSubPool.subPoolAllocator = subPool.opt.subPoolAllocator;
+    releasedSubPool.metadataAllocator = subPool.opt.metadataAllocator;
+    releasedSubPool.isPageMapped = IsSubPoolPageMapped(subPool.opt, releasedSubPool.sizeInBytes);
+
+    subPool.pointers[subPoolID] = nullptr;
+    subPool.pools[subPoolID].pSkipBitmap = nullptr;
+
+    // The list head is empty
+    static_cast<SkipNodeTail&>(subPool.pools[subPoolID]) = SkipNodeTail{};
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
     __KO_POOL_ITERATABLE_ASSERT_DEV__(subPool.pools[subPoolID].numUsed == 0);
     subPool.pools[subPoolID].numUsed = 0;
-#endif
+
+    return releasedSubPool;
+}
+
+void KoPoolIteratable::FreeReleasedSubPool(const ReleasedSubPool& releasedSubPool) noexcept {
+
+    const BlockAllocator& subPoolAllocator = releasedSubPool.subPoolAllocator;
+
+    if (releasedSubPool.pMemory && releasedSubPool.isPageMapped) {
+
+        UnmapPages(releasedSubPool.pMemory, releasedSubPool.sizeInBytes);
+    }
+    else if (releasedSubPool.pMemory && subPoolAllocator.pDeallocate) {
+
+        subPoolAllocator.pDeallocate(
+            subPoolAllocator.pUserData,
+            releasedSubPool.pMemory,
+            releasedSubPool.sizeInBytes,
+            releasedSubPool.alignment,
+            releasedSubPool.subPoolID
+        );
+    }
+    else {
+
+        AlignedFree(releasedSubPool.pMemory);
+    }
+
+    DeallocateMetadata(
+        releasedSubPool.metadataAllocator,
+        releasedSubPool.pSkipBitmap,
+        releasedSubPool.skipBitmapSizeInBytes,
+        alignof(USize),
+        releasedSubPool.subPoolID
+    );
+}
+
+void* KoPoolIteratable::AllocateMetadata(
+    const BlockAllocator& metadataAllocator, const USize sizeInBytes, const USize alignment, const USize subPoolID
+) noexcept {
+
+    if (metadataAllocator.pAllocate) {
+        return metadataAllocator.pAllocate(metadataAllocator.pUserData, sizeInBytes, alignment, subPoolID);
+    }
+
+    return AlignedMalloc(sizeInBytes, alignment);
+}
+
+void KoPoolIteratable::DeallocateMetadata(
+    const BlockAllocator& metadataAllocator, void* pMemory, const USize sizeInBytes, const USize alignment, const USize subPoolID
+) noexcept {
+
+    if (pMemory && metadataAllocator.pDeallocate) {
+
+        metadataAllocator.pDeallocate(metadataAllocator.pUserData, pMemory, sizeInBytes, alignment, subPoolID);
+        return;
+    }
+
+    AlignedFree(pMemory);
+}
+
+bool KoPoolIteratable::IsSubPoolPageMapped(const Opt& opt, const USize sizeInBytes) noexcept {
+
+    return
+        opt.pageMappedSubPoolSizeInBytes != 0 &&
+        sizeInBytes >= opt.pageMappedSubPoolSizeInBytes &&
+        !opt.subPoolAllocator.pAllocate &&
+        opt.elementAlignment <= GetPageSizeInBytes();
+}
+
+void KoPoolIteratable::DestroySubPoolElements(const SubPools& subPool, const USize subPoolID) noexcept {
+
+    const ElementDestructor& elementDestructor = subPool.opt.elementDestructor;
+    USize numToDestroy = subPool.pools[subPoolID].numUsed;
+
+    if (!elementDestructor.pDestroy || numToDestroy == 0) {
+        return;
+    }
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPool.pointers[subPoolID]);
+
+    uint8_t* pSubPool = subPool.pointers[subPoolID];
+    const USize* pSkipBitmap = subPool.pools[subPoolID].pSkipBitmap;
+    const USize elementSizeInBytes = subPool.opt.elementSizeInBytes;
+
+    // The bits past the sub pool size are always set, the free runs are skipped a word at a time
+    for (USize wordID = 0; numToDestroy > 0; ++wordID) {
+
+        USize usedBits = ~pSkipBitmap[wordID];
+
+        while (usedBits != 0) {
+
+            const USize idInSubPool = wordID * DIGITS + static_cast<USize>(Count0BitsRight(usedBits));
+            elementDestructor.pDestroy(elementDestructor.pUserData, pSubPool + idInSubPool * elementSizeInBytes);
+
+            usedBits &= usedBits - 1;
+            numToDestroy -= 1;
+        }
+    }
+}
+
+void KoPoolIteratable::ReleaseSubPool(const USize subPoolID) noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
+
+    RemoveSortedPointer(subPoolID);
+    _generation += 1;
+
+    const SubPoolReclaimer& subPoolReclaimer = _opt.subPoolReclaimer;
+    if (!subPoolReclaimer.pReclaim) {
+
+        DeallocateSubPoolMemory(*_pSubPools, subPoolID);
+        return;
+    }
+
+    subPoolReclaimer.pReclaim(subPoolReclaimer.pUserData, DetachSubPoolMemory(*_pSubPools, subPoolID));
 }
 
 KoPoolIteratable::USize KoPoolIteratable::FindSubPoolIDByPtrImpl(const void* pMemory) const noexcept {
 
     const USize sortedPointerID = FindSortedPointerIDByPtr(pMemory);
-    return _pSubPools->sortedPointers[sortedPointerID].subPoolID;
+    return _pSubPools->sortedSubPoolIDs[sortedPointerID];
 }
 
 KoPoolIteratable::USize KoPoolIteratable::FindSortedPointerIDByPtr(const void* pMemory) const noexcept {
 
     const USize sortedPointersSizePow2 = RoundUpToPowerOf2(_pSubPools->sortedPointersSize);
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(sortedPointersSizePow2 > 0 && sortedPointersSizePow2 <= DIGITS);
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(sortedPointersSizePow2 > 0 && sortedPointersSizePow2 <= SUBPOOLS_CNT);
 
     switch (sortedPointersSizePow2) {
     case 1: {
@@ -518,7 +1392,23 @@ KoPoolIteratable::USize KoPoolIteratable::FindSortedPointerIDByPtr(const void* p
         return BinarySearchSortedPointerIDByPointerPow2Impl<64>(pMemory);
     }
     default: {
-        return BinarySearchSortedPointerIDByPointerPow2Impl<DIGITS>(pMemory);
+
+        // The same search as 'BinarySearchSortedPointerIDByPointerPow2Impl', not unrolled for many sub pools
+        uint8_t* const* pSortedPointers = _pSubPools->sortedPointers.data();
+
+        USize offset = 0;
+        for (USize number = sortedPointersSizePow2; number > 1; number /= 2) {
+
+            const uint8_t* pSortedPointer = pSortedPointers[offset + number / 2];
+
+            if (pSortedPointer && pMemory >= pSortedPointer) {
+                offset += number / 2;
+            }
+        }
+
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPtrInsideSubPool(pMemory, _pSubPools->sortedSubPoolIDs[offset]));
+
+        return offset;
     }
     }
 
@@ -536,15 +1426,8 @@ KoPoolIteratable::USize KoPoolIteratable::FindSortedPointerIDByPtr(const void* p
 
 KoPoolIteratable::PoolID KoPoolIteratable::IDToPtrImpl(const USize id) const noexcept {
 
-    // in 2^0 we store 2 elements
-
-    const USize subPoolID = id < 2
-        ? 0
-        : IDToSubPoolIDImpl(id);
-
-    const USize baseID = id < 2
-        ? 0
-        : (static_cast<USize>(1) << subPoolID);
+    const USize subPoolID = IDToSubPoolIDImpl(id);
+    const USize baseID = GetSubPoolBaseID(_layout, subPoolID);
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools->pointers[subPoolID]);
@@ -561,8 +1444,23 @@ KoPoolIteratable::PoolID KoPoolIteratable::IDToPtrImpl(const USize id) const noe
 
 KoPoolIteratable::USize KoPoolIteratable::IDToSubPoolIDImpl(const USize id) const noexcept {
 
-    const USize subPoolID = Log2(id);
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPoolID < SUBPOOLS_CNT);
+    // in 2^0 we store 2^s elements, the growing sub pools start at 2^(s + g * (k - 1)), the capped ones at multiples of 2^c
+    const USize initialSubPoolSizeLog2 = _layout.initialSubPoolSizeLog2;
+    const USize growthFactorLog2 = _layout.growthFactorLog2;
+    const USize maxSubPoolSizeLog2 = _layout.maxSubPoolSizeLog2;
+
+    USize subPoolID = 0;
+
+    if ((id >> maxSubPoolSizeLog2) != 0) {
+        subPoolID = (id >> maxSubPoolSizeLog2) + _layout.cappedSubPoolID - 1;
+    }
+    else if ((id >> initialSubPoolSizeLog2) != 0) {
+
+        const USize exponent = Log2(id) - initialSubPoolSizeLog2;
+        subPoolID = 1 + (growthFactorLog2 == 1 ? exponent : exponent / growthFactorLog2);
+    }
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPoolID < SUBPOOLS_CNT - 1);
 
     return subPoolID;
 }
@@ -571,10 +1469,7 @@ KoPoolIteratable::PoolID KoPoolIteratable::PtrToIDImpl(const void* pMemory, cons
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPtrInsideSubPool(pMemory, subPoolID));
 
-    // in 2^0 we store 2 elements
-    const USize baseID = subPoolID == 0
-        ? 0
-        : (static_cast<USize>(1) << subPoolID);
+    const USize baseID = GetSubPoolBaseID(_layout, subPoolID);
 
     const USize id = baseID + PtrToIDInSubPool(pMemory, subPoolID);
 
@@ -598,14 +1493,14 @@ KoPoolIteratable::USize KoPoolIteratable::PtrToIDInSubPool(const void* pMemory,
     return offsetInBytes / _opt.elementSizeInBytes;
 }
 
-bool KoPoolIteratable::IsPtrInsideSubPool(const void* pMemory, const size_t subPoolID) const noexcept {
+bool KoPoolIteratable::IsPtrInsideSubPool(const void* pMemory, const USize subPoolID) const noexcept {
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
 
     return
         _pSubPools->pointers[subPoolID] &&
         pMemory >= _pSubPools->pointers[subPoolID] &&
-        pMemory < _pSubPools->pointers[subPoolID] + GetSubPoolSize(subPoolID) * _opt.elementSizeInBytes;
+        pMemory < _pSubPools->pointers[subPoolID] + GetSubPoolSize(_layout, subPoolID) * _opt.elementSizeInBytes;
 }
 
 bool KoPoolIteratable::IsSubPoolEmpty(const USize subPoolID) const noexcept {
@@ -614,40 +1509,38 @@ bool KoPoolIteratable::IsSubPoolEmpty(const USize subPoolID) const noexcept {
 
     const SubPools::Pool& subPool = _pSubPools->pools[subPoolID];
 
+    const SkipNodeBase* pHead = GetNextFreeSkipNodeHead(&subPool, subPoolID);
+
     const bool isEmpty =
-        IsRightSkipListNodeSafe(subPool.pNextFreeSkipNodeHead, subPoolID) &&
-        static_cast<SkipNodeHead*>(subPool.pNextFreeSkipNodeHead)
-            ->numBytesToTail == (GetSubPoolSize(subPoolID) - 1) * _opt.elementSizeInBytes;
+        IsRightSkipListNodeSafe(pHead, subPoolID) &&
+        static_cast<const SkipNodeHead*>(pHead)
+            ->numBytesToTail == (GetSubPoolSize(_layout, subPoolID) - 1) * _opt.elementSizeInBytes;
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
-    if (isEmpty) {
-        __KO_POOL_ITERATABLE_ASSERT_DEV__(subPool.numUsed == 0);
-    }
-#endif
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(!isEmpty || subPool.numUsed == 0);
 
     return isEmpty;
 }
 
 void KoPoolIteratable::ResetSubPool(const USize subPoolID) noexcept {
 
-    const USize size = GetSubPoolSize(subPoolID);
+    const USize size = GetSubPoolSize(_layout, subPoolID);
     __KO_POOL_ITERATABLE_ASSERT_TEST__(size > 1);
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
     SubPools::Pool& subPool = _pSubPools->pools[subPoolID];
 
-    std::memset(subPool.pPrevFreeSkipNodeTail, std::numeric_limits<int>::max(), CeilDiv(size, DIGITS) * sizeof(USize));
+    std::memset(subPool.pSkipBitmap, std::numeric_limits<int>::max(), GetSkipBitmapSizeInBytes(_layout, subPoolID));
 
     SkipNodeHead* pHead = reinterpret_cast<SkipNodeHead*>(_pSubPools->pointers[subPoolID]);
     SkipNodeTail* pTail = reinterpret_cast<SkipNodeTail*>(_pSubPools->pointers[subPoolID] + (size - 1) * _opt.elementSizeInBytes);
 
-    pHead->pPrevFreeSkipNodeTail = &subPool;
-    pHead->numBytesToTail = (size - 1) * _opt.elementSizeInBytes;
+    SetPrevFreeSkipNodeTail(pHead, &subPool, subPoolID);
+    pHead->numBytesToTail = static_cast<SkipNodeSize>((size - 1) * _opt.elementSizeInBytes);
 
-    pTail->pPrevFreeSkipNodeTail = &subPool;
-    pTail->pNextFreeSkipNodeHead = nullptr;
+    SetPrevFreeSkipNodeTail(pTail, &subPool, subPoolID);
+    SetNextFreeSkipNodeHead(pTail, nullptr, subPoolID);
 
-    subPool.pNextFreeSkipNodeHead = pHead;
+    SetNextFreeSkipNodeHead(&subPool, pHead, subPoolID);
     __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPtrInsideSubPool((uint8_t*)pHead, subPoolID));
 }
 
@@ -656,7 +1549,6 @@ KoPoolIteratable::SkipNodeTail* KoPoolIteratable::HeadToTail(SkipNodeBase* pHead
     uint8_t* pHeadNodeBytes = reinterpret_cast<uint8_t*>(pHeadNode);
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(pHeadNode);
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(pHeadNode->pPrevFreeSkipNodeTail);
     __KO_POOL_ITERATABLE_ASSERT_TEST__(!IsLeftSkipListNodeSafe(pHeadNodeBytes, FindSubPoolIDByPtrImpl(pHeadNodeBytes)));
     __KO_POOL_ITERATABLE_ASSERT_TEST__(IsRightSkipListNodeSafe(pHeadNodeBytes, FindSubPoolIDByPtrImpl(pHeadNodeBytes)));
 
@@ -665,16 +1557,17 @@ KoPoolIteratable::SkipNodeTail* KoPoolIteratable::HeadToTail(SkipNodeBase* pHead
     );
 }
 
-KoPoolIteratable::SkipNodeHead* KoPoolIteratable::TailToHead(SkipNodeBase* pTailNode) const noexcept {
+KoPoolIteratable::SkipNodeHead* KoPoolIteratable::TailToHead(SkipNodeBase* pTailNode, const USize subPoolID) const noexcept {
 
     const uint8_t* pTailNodeBytes = reinterpret_cast<uint8_t*>(pTailNode);
 
     __KO_POOL_ITERATABLE_ASSERT_TEST__(pTailNode);
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(pTailNode->pPrevFreeSkipNodeTail);
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(IsLeftSkipListNodeSafe(pTailNodeBytes, FindSubPoolIDByPtrImpl(pTailNodeBytes)));
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(!IsRightSkipListNodeSafe(pTailNodeBytes, FindSubPoolIDByPtrImpl(pTailNodeBytes)));
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(GetPrevFreeSkipNodeTail(pTailNode, subPoolID));
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(FindSubPoolIDByPtrImpl(pTailNodeBytes) == subPoolID);
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(IsLeftSkipListNodeSafe(pTailNodeBytes, subPoolID));
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(!IsRightSkipListNodeSafe(pTailNodeBytes, subPoolID));
 
-    return reinterpret_cast<SkipNodeHead*>(pTailNode->pPrevFreeSkipNodeTail->pNextFreeSkipNodeHead);
+    return static_cast<SkipNodeHead*>(GetNextFreeSkipNodeHead(GetPrevFreeSkipNodeTail(pTailNode, subPoolID), subPoolID));
 }
 
 void KoPoolIteratable::HeadNodeSetPrevFreeSkipNodeTail(
@@ -701,15 +1594,82 @@ void KoPoolIteratable::HeadNodeSetPrevFreeSkipNodeTail(
     }
 #endif
 
-    pHeadNode->pPrevFreeSkipNodeTail = pTailToSet;
+    SetPrevFreeSkipNodeTail(pHeadNode, pTailToSet, subPoolID);
 
     if (IsRightSkipListNodeSafe(pHeadNode, subPoolID)) {
 
         SkipNodeTail* pTail = HeadToTail(pHeadNode);
-        pTail->pPrevFreeSkipNodeTail = pTailToSet;
+        SetPrevFreeSkipNodeTail(pTail, pTailToSet, subPoolID);
+    }
+}
+
+#ifdef __KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__
+
+KoPoolIteratable::SkipNodeBase* KoPoolIteratable::DecodeSkipNode(const SkipNodeOffset offset, const USize subPoolID) const noexcept {
+
+    if (offset == SKIP_NODE_OFFSET_NONE) {
+        return nullptr;
     }
+
+    if (offset == SKIP_NODE_OFFSET_POOL) {
+        return &_pSubPools->pools[subPoolID];
+    }
+
+    return reinterpret_cast<SkipNodeBase*>(_pSubPools->pointers[subPoolID] + offset);
+}
+
+KoPoolIteratable::SkipNodeOffset KoPoolIteratable::EncodeSkipNode(const SkipNodeBase* pNode, const USize subPoolID) const noexcept {
+
+    if (!pNode) {
+        return SKIP_NODE_OFFSET_NONE;
+    }
+
+    if (pNode == &_pSubPools->pools[subPoolID]) {
+        return SKIP_NODE_OFFSET_POOL;
+    }
+
+    const uint8_t* pNodeBytes = reinterpret_cast<const uint8_t*>(pNode);
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPtrInsideSubPool(pNodeBytes, subPoolID));
+    return static_cast<SkipNodeOffset>(pNodeBytes - _pSubPools->pointers[subPoolID]);
+}
+
+KoPoolIteratable::SkipNodeTail* KoPoolIteratable::GetPrevFreeSkipNodeTail(const SkipNodeBase* pNode, const USize subPoolID) const noexcept {
+    return static_cast<SkipNodeTail*>(DecodeSkipNode(pNode->prevFreeSkipNodeTailOffset, subPoolID));
+}
+
+void KoPoolIteratable::SetPrevFreeSkipNodeTail(SkipNodeBase* pNode, SkipNodeTail* pTail, const USize subPoolID) const noexcept {
+    pNode->prevFreeSkipNodeTailOffset = EncodeSkipNode(pTail, subPoolID);
 }
 
+KoPoolIteratable::SkipNodeBase* KoPoolIteratable::GetNextFreeSkipNodeHead(const SkipNodeTail* pTail, const USize subPoolID) const noexcept {
+    return DecodeSkipNode(pTail->nextFreeSkipNodeHeadOffset, subPoolID);
+}
+
+void KoPoolIteratable::SetNextFreeSkipNodeHead(SkipNodeTail* pTail, SkipNodeBase* pHead, const USize subPoolID) const noexcept {
+    pTail->nextFreeSkipNodeHeadOffset = EncodeSkipNode(pHead, subPoolID);
+}
+
+#else
+
+KoPoolIteratable::SkipNodeTail* KoPoolIteratable::GetPrevFreeSkipNodeTail(const SkipNodeBase* pNode, const USize) const noexcept {
+    return pNode->pPrevFreeSkipNodeTail;
+}
+
+void KoPoolIteratable::SetPrevFreeSkipNodeTail(SkipNodeBase* pNode, SkipNodeTail* pTail, const USize) const noexcept {
+    pNode->pPrevFreeSkipNodeTail = pTail;
+}
+
+KoPoolIteratable::SkipNodeBase* KoPoolIteratable::GetNextFreeSkipNodeHead(const SkipNodeTail* pTail, const USize) const noexcept {
+    return pTail->pNextFreeSkipNodeHead;
+}
+
+void KoPoolIteratable::SetNextFreeSkipNodeHead(SkipNodeTail* pTail, SkipNodeBase* pHead, const USize) const noexcept {
+    pTail->pNextFreeSkipNodeHead = pHead;
+}
+
+#endif
+
 bool KoPoolIteratable::IsSkipListNode(const void* pMemory, const USize subPoolID) const noexcept {
 
     return IsSkipListNodeByIDInSubPool(PtrToIDInSubPool(pMemory, subPoolID), subPoolID);
@@ -720,11 +1680,11 @@ bool KoPoolIteratable::IsSkipListNodeByIDInSubPool(const USize idInSubPool, cons
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
     const SubPools::Pool& subPool = _pSubPools->pools[subPoolID];
 
-    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPool.pPrevFreeSkipNodeTail);
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(subPool.pSkipBitmap);
 
     const USize bitID = (idInSubPool & (DIGITS - 1));
 
-    return ((reinterpret_cast<USize*>(subPool.pPrevFreeSkipNodeTail)[idInSubPool / DIGITS] >> bitID) & 0b1) == 1;
+    return ((subPool.pSkipBitmap[idInSubPool / DIGITS] >> bitID) & 0b1) == 1;
 }
 
 void KoPoolIteratable::SetIsSkipListNode(const void* pMemory, const USize subPoolID, const bool isSkipListNode) noexcept {
@@ -737,11 +1697,11 @@ void KoPoolIteratable::SetIsSkipListNode(const void* pMemory, const USize subPoo
 
     if (isSkipListNode) {
 
-        reinterpret_cast<USize*>(subPool.pPrevFreeSkipNodeTail)[id / DIGITS] |= (static_cast<USize>(1) << bitID);
+        subPool.pSkipBitmap[id / DIGITS] |= (static_cast<USize>(1) << bitID);
     }
     else {
 
-        reinterpret_cast<USize*>(subPool.pPrevFreeSkipNodeTail)[id / DIGITS] &= ~(static_cast<USize>(1) << bitID);
+        subPool.pSkipBitmap[id / DIGITS] &= ~(static_cast<USize>(1) << bitID);
     }
 }
 
@@ -752,11 +1712,11 @@ bool KoPoolIteratable::IsRightSkipListNodeSafe(const void* pMemory_, const USize
     __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
     __KO_POOL_ITERATABLE_ASSERT_TEST__(
         pMemory + _opt.elementSizeInBytes <=
-            _pSubPools->pointers[subPoolID] + GetSubPoolSize(subPoolID) * _opt.elementSizeInBytes
+            _pSubPools->pointers[subPoolID] + GetSubPoolSize(_layout, subPoolID) * _opt.elementSizeInBytes
     );
 
     const bool isEnd = pMemory + _opt.elementSizeInBytes ==
-        _pSubPools->pointers[subPoolID] + GetSubPoolSize(subPoolID) * _opt.elementSizeInBytes;
+        _pSubPools->pointers[subPoolID] + GetSubPoolSize(_layout, subPoolID) * _opt.elementSizeInBytes;
 
     return !isEnd && IsSkipListNode(pMemory + _opt.elementSizeInBytes, subPoolID);
 }
@@ -1,10 +1,29 @@
 #pragma once
 
 #include <array>
+#include <vector>
 #include <memory>
+#include <type_traits>
 
 //#define __KO_POOL_ITERATABLE_DEV__
 //#define __KO_POOL_ITERATABLE_TEST__
+//#define __KO_POOL_ITERATABLE_INSTRUMENTATION__
+
+// Skip nodes store 32 bit byte offsets from the sub pool instead of pointers, so elements of 8 bytes are supported
+// and the skip nodes are position independent. Sub pools are capped to 'COMPACT_SUB_POOL_SIZE_IN_BYTES_MAX'
+//#define __KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__
+
+// Type of IDs, sizes and counters ('USize'). 'uint32_t' halves the stored IDs and the pool metadata,
+// a pool has < 2^32 elements and the sizes in bytes must fit too
+#ifndef __KO_POOL_ITERATABLE_USIZE__
+#define __KO_POOL_ITERATABLE_USIZE__ size_t
+#endif
+
+// Number of sub pools (one is reserved), a power of 2 >= 8. Raise it with 'Opt::maxSubPoolSize',
+// e.g. 256 sub pools of 2^16 elements, or lower it for small pools, e.g. 32 sub pools reach 2^30 elements
+#ifndef __KO_POOL_ITERATABLE_SUBPOOLS_CNT__
+#define __KO_POOL_ITERATABLE_SUBPOOLS_CNT__ std::numeric_limits<__KO_POOL_ITERATABLE_USIZE__>::digits
+#endif
 
 #if defined(_MSC_VER)
 #define __KO_POOL_UNREACHABLE__() do { __assume(0); } while(0)
@@ -57,20 +76,156 @@ do { \
 
 #endif // __KO_POOL_ITERATABLE_TEST__
 
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+
+#include "KoPoolInstrumentation.h"
+
+#else
+
+#define __KO_POOL_ITERATABLE_INSTRUMENT_SCOPE__(instrumentation, event)
+
+#endif // __KO_POOL_ITERATABLE_INSTRUMENTATION__
+
 template <typename T>
 class KoPoolIterator;
 
+template <typename ...Ts>
+class KoPoolColumnsIterator;
+
 class KoPoolIteratable {
 public:
 
-    using USize = size_t;
+    using USize = __KO_POOL_ITERATABLE_USIZE__;
+
+    static constexpr USize SUBPOOLS_CNT = __KO_POOL_ITERATABLE_SUBPOOLS_CNT__;
+
+    // Sub pool ID with 'SUB_POOL_ID_NONE' in the sorted pointers
+    using SubPoolIDSmall = std::conditional_t<(SUBPOOLS_CNT < 256), uint8_t, uint16_t>;
+
+#ifdef __KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__
+
+    // 'SkipNodeHead' and 'SkipNodeTail' are stored inside of the vacant elements
+    static constexpr USize MIN_ELEMENT_SIZE_IN_BYTES = sizeof(uint32_t) + sizeof(uint32_t);
+
+    // Column 0 of a sub pool, the skip node offsets fit in 32 bits with 'SKIP_NODE_OFFSET_NONE' and 'SKIP_NODE_OFFSET_POOL'
+    static constexpr USize COMPACT_SUB_POOL_SIZE_IN_BYTES_MAX = static_cast<USize>(1) << 31;
+#else
+
+    // 'SkipNodeHead' and 'SkipNodeTail' are stored inside of the vacant elements
+    static constexpr USize MIN_ELEMENT_SIZE_IN_BYTES = sizeof(void*) + sizeof(uintptr_t);
+#endif
+
+    static constexpr USize COLUMNS_CNT_MAX = 8;
+
+    // Allocates the memory of sub pools (elements of the sub pool), e.g. to track the memory ranges of the pool
+    struct BlockAllocator {
+
+        void* (*pAllocate)(void* pUserData, USize sizeInBytes, USize alignment, USize subPoolID) noexcept = nullptr;
+        void (*pDeallocate)(void* pUserData, void* pMemory, USize sizeInBytes, USize alignment, USize subPoolID) noexcept = nullptr;
+
+        void* pUserData = nullptr;
+    };
+
+    // Memory of a released sub pool which is detached from the pool, see 'SubPoolReclaimer'
+    struct ReleasedSubPool {
+
+        uint8_t* pMemory = nullptr;
+        USize sizeInBytes = 0;
+        USize alignment = 0;
+        USize subPoolID = 0;
+
+        void* pSkipBitmap = nullptr;
+        USize skipBitmapSizeInBytes = 0;
+
+        // Copies of 'Opt::subPoolAllocator' and 'Opt::metadataAllocator', 'pMemory' and 'pSkipBitmap' are deallocated by them
+        BlockAllocator subPoolAllocator{};
+        BlockAllocator metadataAllocator{};
+
+        // 'pMemory' is mapped by pages, see 'Opt::pageMappedSubPoolSizeInBytes'
+        bool isPageMapped = false;
+    };
+
+    // Frees 'ReleasedSubPool', can be called from any thread
+    static void FreeReleasedSubPool(const ReleasedSubPool& releasedSubPool) noexcept;
+
+    // Takes the sub pools which become empty in 'Deallocate...()' instead of freeing them synchronously,
+    // so no single deallocation pays the free/unmap of a large sub pool. The receiver must call 'FreeReleasedSubPool(...)'
+    // later, e.g. 'KoPoolReclaimer'. 'DeallocateBytesAll()' and the destructor still free synchronously
+    struct SubPoolReclaimer {
+
+        void (*pReclaim)(void* pUserData, const ReleasedSubPool& releasedSubPool) noexcept = nullptr;
+        void* pUserData = nullptr;
+    };
 
-    static constexpr USize SUBPOOLS_CNT = std::numeric_limits<USize>::digits;
+    // Destructor of the elements for the untyped teardown, see 'Opt::elementDestructor'
+    struct ElementDestructor {
+
+        void (*pDestroy)(void* pUserData, void* pElement) noexcept = nullptr;
+        void* pUserData = nullptr;
+    };
+
+    template <typename T>
+    static ElementDestructor MakeElementDestructor() noexcept {
+
+        ElementDestructor elementDestructor{};
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            elementDestructor.pDestroy = [](void*, void* pElement) noexcept { reinterpret_cast<T*>(pElement)->~T(); };
+        }
+
+        return elementDestructor;
+    }
 
     struct Opt {
 
         USize elementSizeInBytes = sizeof(USize);
         USize elementAlignment = alignof(USize);
+
+        // Structure of arrays: each sub pool stores 'columnsCnt' parallel arrays indexed by the same ID.
+        // Column 0 is the element ('elementSizeInBytes', 'elementAlignment'), it stores skip nodes,
+        // so 'columnSizesInBytes[0]' and 'columnAlignments[0]' are ignored. Other columns are raw memory
+        USize columnsCnt = 1;
+        std::array<USize, COLUMNS_CNT_MAX> columnSizesInBytes{};
+        std::array<USize, COLUMNS_CNT_MAX> columnAlignments{};
+
+        // If not set, 'AlignedMalloc' is used
+        BlockAllocator subPoolAllocator{};
+
+        // Allocates the skip bit sets (the 'subPoolID' of the sub pool) and the sub pools metadata ('SUB_POOL_ID_NONE'),
+        // e.g. to share the small blocks of many pools, see 'KoPoolBlockCache'. If not set, 'AlignedMalloc' is used
+        BlockAllocator metadataAllocator{};
+
+        // Power of 2 or 0 (unlimited). Sub pools double until 'maxSubPoolSize' elements, then each new sub pool has
+        // 'maxSubPoolSize' elements, so the allocation which opens a sub pool (and the deallocation which releases it)
+        // allocates, resets the bit set of and touches a bounded memory. Capacity is limited by 'SUBPOOLS_CNT'
+        USize maxSubPoolSize = 0;
+
+        // Power of 2 >= 2, the number of elements of sub pool 0. Small pools (e.g. 1000 elements with 4096) fit
+        // in one sub pool, so the iteration doesn't jump between many tiny sub pools
+        USize initialSubPoolSize = 2;
+
+        // Power of 2 >= 2, the ratio of the first IDs of the neighbouring sub pools, e.g. 4 reaches the large
+        // sub pools in half of the sub pools. The sizes aren't powers of 2 then, e.g. 2^s, 3 * 2^s, 12 * 2^s
+        USize growthFactor = 2;
+
+        // If not set, the released sub pools are freed in 'Deallocate...()'
+        SubPoolReclaimer subPoolReclaimer{};
+
+        // Sub pools of >= 'pageMappedSubPoolSizeInBytes' bytes (0 - none) are mapped by pages ('mmap'/'VirtualAlloc')
+        // instead of 'AlignedMalloc', so a page is committed when an element of it is touched first and 'Trim()'
+        // returns the pages inside of free runs to the OS. Ignored with 'subPoolAllocator'
+        USize pageMappedSubPoolSizeInBytes = 0;
+
+        // The skip bit set is placed in front of the elements of the sub pool, in the same block, instead of
+        // a separate 'metadataAllocator' block, so a sub pool is one allocation and the iteration reads
+        // the bit set next to the elements
+        bool isSkipBitmapColocated = false;
+
+        // If set, 'DeallocateBytesAll()', 'Reset()' and the destructor of the pool destroy the remaining elements,
+        // walking the bit set of each sub pool a word at a time right before the sub pool is released, so a teardown
+        // touches each sub pool once instead of a separate 'KoPoolIterator' pass. 'DeallocateBytes...()' don't
+        // call it, the typed 'Deallocate...()' call the destructor of 'T'. See 'MakeElementDestructor<T>()'
+        ElementDestructor elementDestructor{};
     };
 
     KoPoolIteratable() noexcept = default;
@@ -135,6 +290,21 @@ public:
         DeallocateBySubPoolID(reinterpret_cast<T*>(poolID.pMemory), poolID.subPoolID);
     }
 
+    // All IDs in ['firstID', 'lastID'] must be allocated, see 'DeallocateBytesRange(...)'.
+    // The destructors run per element, the trivially destructible elements aren't visited
+    template <typename T>
+    void DeallocateRange(const USize firstID, const USize lastID) noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+
+            for (USize id = firstID; id <= lastID; ++id) {
+                reinterpret_cast<T*>(IDToPtr(id))->~T();
+            }
+        }
+
+        DeallocateBytesRange(firstID, lastID);
+    }
+
     template <typename T>
     void DeallocateBySubPoolID(T* pMemory, const USize subPoolID) noexcept(std::is_nothrow_destructible_v<T>) {
 
@@ -153,6 +323,9 @@ public:
     struct AllocBytesResult {
         USize subPoolID = SUB_POOL_ID_NONE;
         uint8_t* pMemory = nullptr;
+
+        // Global ID ('PtrToID(...)'), valid when 'pMemory' isn't nullptr
+        USize id = 0;
     };
     AllocBytesResult AllocateBytes() noexcept;
 
@@ -160,8 +333,69 @@ public:
     void DeallocateBytesByID(const USize id) noexcept;
     void DeallocateBytesByPtrAndSubPoolID(void* pMemory, const USize subPoolID) noexcept;
 
+    // Frees the allocated IDs in ['firstID', 'lastID'], e.g. a batch allocated together. Per sub pool the skip bits
+    // are set a word at a time and the range becomes one skip node merged with the free neighbours,
+    // so the cost is the number of the sub pools and the bit set words, not the number of the elements
+    void DeallocateBytesRange(const USize firstID, const USize lastID) noexcept;
+
     void DeallocateBytesAll() noexcept;
 
+    // Frees all elements but keeps the sub pools: each one becomes a single free run, so the next fill
+    // (e.g. the next frame) doesn't allocate, reset or fault the sub pools again. Unlike 'DeallocateBytesAll()'
+    // the empty sub pools aren't released, 'Trim()' and 'DeallocateBytesAll()' still can release them
+    void Reset() noexcept;
+
+    // 'Reset()' after the destructors of all elements, run in one pass in memory order.
+    // The pass is skipped for the trivially destructible elements and with 'Opt::elementDestructor', 'Reset()' runs it
+    template <typename T>
+    void Clear() noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+
+            if (!IsEmpty() && !_opt.elementDestructor.pDestroy) {
+
+                KoPoolIterator<T> iterator{ *this };
+                while (T* pData = iterator.Next()) {
+                    pData->~T();
+                }
+            }
+        }
+
+        Reset();
+    }
+
+    // Queues the element, it stays allocated and iteratable until 'FlushDeferred()' destroys and frees it,
+    // so it can be called inside of an iteration without 'GetFixedIteratorAfterDeallocate(...)'
+    template <typename T>
+    void DeallocateLater(T* pMemory) {
+
+        if (!pMemory) {
+            return;
+        }
+
+        DeferredDeallocation deferred{};
+        deferred.pMemory = reinterpret_cast<uint8_t*>(pMemory);
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            deferred.pDestroy = [](void* pData) noexcept { reinterpret_cast<T*>(pData)->~T(); };
+        }
+
+        _deferredDeallocations.push_back(deferred);
+    }
+
+    void DeallocateBytesLater(void* pMemory);
+
+    // Destroys the queued elements, then frees them sorted by address: the sub pool is searched once per run
+    // of its elements, and each run of the adjacent IDs is freed at once ('DeallocateBytesRange(...)').
+    // Must not be called inside of an iteration. Returns the number of the freed elements
+    USize FlushDeferred() noexcept;
+    USize GetNumDeferred() const noexcept;
+
+    // Returns the pages which are inside of free runs of the page mapped sub pools to the OS
+    // ('MADV_DONTNEED'/'MEM_RESET') and releases the retained empty sub pool. Returns the number of returned bytes,
+    // the sub pool handed to 'Opt::subPoolReclaimer' isn't counted, the reclaimer frees it
+    USize Trim() noexcept;
+
     uint8_t* IDToPtr(const USize id) const noexcept;
     USize IDToSubPoolID(const USize id) const noexcept;
 
@@ -177,7 +411,7 @@ public:
         return KoPoolIterator<T>{ *this };
     }
 
-    template <typename T, std::enable_if_t<!std::is_abstract<T>::value>* = nullptr>
+    template <typename T, std::enable_if_t<!std::is_abstract<T>::value && !std::is_void<T>::value>* = nullptr>
     KoPoolIterator<T> GetIterator() const noexcept {
 
         __KO_POOL_ITERATABLE_ASSERT_DEV__(sizeof(T) == _opt.elementSizeInBytes);
@@ -186,8 +420,112 @@ public:
         return KoPoolIterator<T>{ *this };
     }
 
+    template <typename ...Ts>
+    KoPoolColumnsIterator<Ts...> GetColumnsIterator(const std::array<USize, sizeof...(Ts)>& columnIDs) const noexcept {
+
+        return KoPoolColumnsIterator<Ts...>{ *this, columnIDs };
+    }
+
+    // Iterates untyped elements of 'Opt::elementSizeInBytes'
+    template <typename T, std::enable_if_t<std::is_void<T>::value>* = nullptr>
+    KoPoolIterator<T> GetIterator() const noexcept {
+
+        return KoPoolIterator<T>{ *this };
+    }
+
+    // Structure of arrays, see 'Opt::columnsCnt'. The column pointer is stable like the element pointer
+    uint8_t* GetColumnPtr(const void* pMemory, const USize subPoolID, const USize columnID) const noexcept;
+    uint8_t* IDToColumnPtr(const USize id, const USize columnID) const noexcept;
+
+    template <typename T>
+    T* GetColumn(const void* pMemory, const USize subPoolID, const USize columnID) const noexcept {
+
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(columnID < _opt.columnsCnt);
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(sizeof(T) == _layout.columnSizesInBytes[columnID]);
+
+        return reinterpret_cast<T*>(GetColumnPtr(pMemory, subPoolID, columnID));
+    }
+
     bool IsEmpty() const noexcept;
 
+    const Opt& GetOpt() const noexcept;
+
+    // Number of allocated elements, the sum of the counters of the sub pools which have elements
+    USize Size() const noexcept;
+
+    // Changes when a sub pool is allocated or released, on 'DeallocateAll()', 'Reset()' and on a move,
+    // not on each allocation and deallocation, e.g. 'KoPoolRankIndex' rebuilds when it differs
+    USize GetGeneration() const noexcept;
+
+    // Number of elements of the allocated sub pools
+    USize Capacity() const noexcept;
+
+    // Memory of the sub pools, skip bitmaps and sub pools metadata
+    USize BytesReserved() const noexcept;
+
+    // 'subPoolID' < 'SUBPOOLS_CNT' - 1
+    USize GetSubPoolNumUsed(const USize subPoolID) const noexcept;
+    USize GetSubPoolCapacity(const USize subPoolID) const noexcept;
+
+    struct SubPoolStats {
+
+        USize subPoolID = 0;
+
+        USize numSlots = 0;
+        USize numUsed = 0;
+
+        // 'freeRunsHistogram[i]' is the number of free runs which length is in [2^i, 2^(i + 1))
+        USize numFreeRuns = 0;
+        std::array<USize, std::numeric_limits<USize>::digits> freeRunsHistogram{};
+
+        USize dataSizeInBytes = 0;
+        USize skipBitmapSizeInBytes = 0;
+
+        // The sub pool is empty and will be deallocated when another sub pool becomes empty, see '_subPoolToDeallocate'
+        bool isPendingRelease = false;
+    };
+
+    struct Stats {
+
+        // Only allocated sub pools, ordered by ID
+        std::vector<SubPoolStats> subPools;
+
+        USize numSlots = 0;
+        USize numUsed = 0;
+
+        USize numFreeRuns = 0;
+        std::array<USize, std::numeric_limits<USize>::digits> freeRunsHistogram{};
+
+        USize dataSizeInBytes = 0;
+        USize skipBitmapSizeInBytes = 0;
+        USize metadataSizeInBytes = 0;
+    };
+
+    // Walks skip bitmaps word by word
+    Stats GetStats() const;
+
+    struct StatsCursor {
+
+        bool isStarted = false;
+        bool isSubPoolStarted = false;
+
+        USize subPoolID = 0;
+        USize wordID = 0;
+        USize freeRunLength = 0;
+
+        Stats stats;
+    };
+
+    // Incremental 'GetStats()', walks at most 'maxWords' skip bitmap words per call. Returns true when 'cursor.stats'
+    // is complete, the next call starts a new snapshot. The snapshot is approximate if the pool is changed between calls
+    bool CollectStats(StatsCursor& cursor, const USize maxWords) const;
+
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+
+    const KoPoolInstrumentation& GetInstrumentation() const noexcept;
+    void ResetInstrumentation() noexcept;
+#endif
+
 private:
 
     struct SubPools;
@@ -196,10 +534,58 @@ private:
     struct SkipNodeHead;
     struct SkipNodeTail;
 
-    struct SortedPointer;
 
-    static USize GetSubPoolSize(const USize subPoolID) noexcept;
+    struct Layout {
+
+        // Sum of all columns of one ID
+        USize slotSizeInBytes = 0;
+
+        std::array<USize, COLUMNS_CNT_MAX> columnSizesInBytes{};
+
+        // Offset of the column array inside of the sub pool is 'GetSubPoolSize(...)' * 'columnOffsetsInBytes[columnID]'
+        std::array<USize, COLUMNS_CNT_MAX> columnOffsetsInBytes{};
+
+        // Sub pool 0 has 2^'initialSubPoolSizeLog2' elements, sub pool k starts at the ID
+        // 2^('initialSubPoolSizeLog2' + 'growthFactorLog2' * (k - 1)), see 'Opt::initialSubPoolSize', 'Opt::growthFactor'
+        USize initialSubPoolSizeLog2 = 1;
+        USize growthFactorLog2 = 1;
+
+        // Sub pools from 'cappedSubPoolID' have 2^'maxSubPoolSizeLog2' elements, see 'Opt::maxSubPoolSize'
+        USize maxSubPoolSizeLog2 = DIGITS - 2;
+        USize cappedSubPoolID = DIGITS - 2;
+    };
+
+    static Layout MakeLayout(const Opt& opt) noexcept;
+
+    static USize GetSubPoolSize(const Layout& layout, const USize subPoolID) noexcept;
+    static USize GetSubPoolBaseID(const Layout& layout, const USize subPoolID) noexcept;
+    static USize GetSkipBitmapSizeInBytes(const Layout& layout, const USize subPoolID) noexcept;
+    static USize GetSubPoolReservedBytes(const SubPools& subPool, const USize subPoolID) noexcept;
+
+    // Bytes in front of the elements, the skip bit set padded to the alignment with 'Opt::isSkipBitmapColocated', otherwise 0
+    static USize GetSkipBitmapOffsetInBytes(const SubPools& subPool, const USize subPoolID) noexcept;
+
+    // Block of the sub pool: 'GetSkipBitmapOffsetInBytes(...)' and the columns
+    static USize GetSubPoolBlockSizeInBytes(const SubPools& subPool, const USize subPoolID) noexcept;
+    static uint8_t* AllocateSubPoolMemory(const SubPools& subPool, const USize subPoolID) noexcept;
     static void DeallocateSubPoolMemory(SubPools& subPool, const USize subPoolID) noexcept;
+    static ReleasedSubPool DetachSubPoolMemory(SubPools& subPool, const USize subPoolID) noexcept;
+    static bool IsSubPoolPageMapped(const Opt& opt, const USize sizeInBytes) noexcept;
+
+    static void* AllocateMetadata(const BlockAllocator& metadataAllocator, const USize sizeInBytes, const USize alignment, const USize subPoolID) noexcept;
+    static void DeallocateMetadata(const BlockAllocator& metadataAllocator, void* pMemory, const USize sizeInBytes, const USize alignment, const USize subPoolID) noexcept;
+
+    // Deallocates the empty sub pool or hands it to 'Opt::subPoolReclaimer'
+    void ReleaseSubPool(const USize subPoolID) noexcept;
+
+    // Calls 'Opt::elementDestructor' for the allocated elements of the sub pool, a bit set word at a time
+    static void DestroySubPoolElements(const SubPools& subPool, const USize subPoolID) noexcept;
+
+    // Keeps one empty sub pool (the lowest), releases the other one
+    void ReleaseSubPoolIfEmpty(const USize subPoolID) noexcept;
+
+    // ['idInSubPoolBegin', 'idInSubPoolEnd'] of 'DeallocateBytesRange(...)'
+    void DeallocateBytesRangeInSubPool(const USize subPoolID, const USize idInSubPoolBegin, const USize idInSubPoolEnd) noexcept;
 
     static __KO_POOL_FORCE_INLINE__ constexpr bool IsPowerOf2(const USize num) noexcept {
         return num != 0 && ((num & (num - 1)) == 0);
@@ -215,7 +601,7 @@ private:
 #else
 
         return num != 0
-            ? __builtin_clzl(num)
+            ? __builtin_clz(num)
             : 32;
 #endif
     }
@@ -244,7 +630,7 @@ private:
 #else
 
         return num != 0
-            ? __builtin_ctzl(num)
+            ? __builtin_ctz(num)
             : 32;
 #endif
     }
@@ -264,6 +650,24 @@ private:
 #endif
     }
 
+    static __KO_POOL_FORCE_INLINE__ uint32_t CountSetBits(const uint32_t num) noexcept {
+
+#ifdef _MSC_VER
+        return static_cast<uint32_t>(__popcnt(num));
+#else
+        return static_cast<uint32_t>(__builtin_popcount(num));
+#endif
+    }
+
+    static __KO_POOL_FORCE_INLINE__ uint64_t CountSetBits(const uint64_t num) noexcept {
+
+#ifdef _MSC_VER
+        return static_cast<uint64_t>(__popcnt64(num));
+#else
+        return static_cast<uint64_t>(__builtin_popcountll(num));
+#endif
+    }
+
     static USize Log2(const USize num) noexcept {
 
         return num == 0
@@ -284,6 +688,69 @@ private:
         return static_cast<USize>(1) << (DIGITS - Count0BitsLeft(num));
     }
 
+    // Bit per sub pool
+    using SubPoolsMask = std::array<
+        USize, (SUBPOOLS_CNT + std::numeric_limits<USize>::digits - 1) / std::numeric_limits<USize>::digits
+    >;
+
+    static SubPoolsMask MakeSubPoolsMaskFull() noexcept {
+
+        SubPoolsMask mask{};
+        mask.fill(std::numeric_limits<USize>::max());
+
+        // Less sub pools than bits in a word, 'FindSubPoolsMaskBit(...)' doesn't return IDs > 'SUB_POOL_ID_NONE'
+        if (SUBPOOLS_CNT < DIGITS) {
+            mask[0] = (static_cast<USize>(1) << (SUBPOOLS_CNT % DIGITS)) - 1;
+        }
+
+        return mask;
+    }
+
+    static __KO_POOL_FORCE_INLINE__ bool IsSubPoolsMaskEmpty(const SubPoolsMask& mask) noexcept {
+
+        for (const USize word : mask) {
+
+            if (word != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static __KO_POOL_FORCE_INLINE__ void SetSubPoolsMaskBit(SubPoolsMask& mask, const USize subPoolID) noexcept {
+        mask[subPoolID / DIGITS] |= (static_cast<USize>(1) << (subPoolID & (DIGITS - 1)));
+    }
+
+    static __KO_POOL_FORCE_INLINE__ void ResetSubPoolsMaskBit(SubPoolsMask& mask, const USize subPoolID) noexcept {
+        mask[subPoolID / DIGITS] &= ~(static_cast<USize>(1) << (subPoolID & (DIGITS - 1)));
+    }
+
+    // First set bit >= 'subPoolID', or 'SUB_POOL_ID_NONE'
+    static __KO_POOL_FORCE_INLINE__ USize FindSubPoolsMaskBit(const SubPoolsMask& mask, const USize subPoolID) noexcept {
+
+        USize wordID = subPoolID / DIGITS;
+        if (wordID >= mask.size()) {
+            return SUB_POOL_ID_NONE;
+        }
+
+        USize word = mask[wordID] & (std::numeric_limits<USize>::max() << (subPoolID & (DIGITS - 1)));
+
+        for (;;) {
+
+            if (word != 0) {
+                return wordID * DIGITS + Count0BitsRight(word);
+            }
+
+            wordID += 1;
+            if (wordID == mask.size()) {
+                return SUB_POOL_ID_NONE;
+            }
+
+            word = mask[wordID];
+        }
+    }
+
     struct PoolID {
         USize subPoolID = SUB_POOL_ID_NONE;
         USize id = 0;
@@ -309,30 +776,24 @@ private:
             BinarySearchSortedPointerIDByPointerPow2Impl<NUMBER>(pMemory, offset);
 
         __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
-        return _pSubPools->sortedPointers[sortedPointerID].subPoolID;
+        return _pSubPools->sortedSubPoolIDs[sortedPointerID];
     }
 
     template <USize NUMBER>
     __KO_POOL_FORCE_INLINE__ USize BinarySearchSortedPointerIDByPointerPow2Impl(const void* pMemory, const USize offset = 0) const noexcept {
 
         __KO_POOL_ITERATABLE_ASSERT_TEST__(_pSubPools);
-        const KoPoolIteratable::SortedPointer* pSortedPointers = _pSubPools->sortedPointers.data() + offset;
+        uint8_t* const* pSortedPointers = _pSubPools->sortedPointers.data() + offset;
 
         if (NUMBER == 0) {
 
-            const bool isPtrInsideSubPool =
-                pMemory >= pSortedPointers[NUMBER].pMemory &&
-                pMemory < pSortedPointers[NUMBER].pMemory +
-                    GetSubPoolSize(pSortedPointers[NUMBER].subPoolID) * _opt.elementSizeInBytes;
-
-            __KO_POOL_ITERATABLE_ASSERT_TEST__(isPtrInsideSubPool);
-
+            __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPtrInsideSubPool(pMemory, _pSubPools->sortedSubPoolIDs[offset]));
             return offset;
         }
 
         __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPowerOf2(NUMBER));
 
-        if (!pSortedPointers[NUMBER / 2].pMemory || pMemory < pSortedPointers[NUMBER / 2].pMemory) {
+        if (!pSortedPointers[NUMBER / 2] || pMemory < pSortedPointers[NUMBER / 2]) {
             return BinarySearchSortedPointerIDByPointerPow2Impl<NUMBER / 2>(pMemory, offset);
         }
         else {
@@ -344,9 +805,16 @@ private:
     void RemoveSortedPointer(const USize subPoolID) noexcept;
 
     SkipNodeTail* HeadToTail(SkipNodeBase* pHeadNode) const noexcept;
-    SkipNodeHead* TailToHead(SkipNodeBase* pTailNode) const noexcept;
+    SkipNodeHead* TailToHead(SkipNodeBase* pTailNode, const USize subPoolID) const noexcept;
     void HeadNodeSetPrevFreeSkipNodeTail(SkipNodeBase* pHeadNode, SkipNodeTail* pTailToSet, const USize subPoolID) const noexcept;
 
+    // Links of the skip nodes, 'SubPools::Pool' of the sub pool is the list head.
+    // With '__KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__' they are decoded from the offsets from the sub pool
+    SkipNodeTail* GetPrevFreeSkipNodeTail(const SkipNodeBase* pNode, const USize subPoolID) const noexcept;
+    void SetPrevFreeSkipNodeTail(SkipNodeBase* pNode, SkipNodeTail* pTail, const USize subPoolID) const noexcept;
+    SkipNodeBase* GetNextFreeSkipNodeHead(const SkipNodeTail* pTail, const USize subPoolID) const noexcept;
+    void SetNextFreeSkipNodeHead(SkipNodeTail* pTail, SkipNodeBase* pHead, const USize subPoolID) const noexcept;
+
     bool IsSkipListNode(const void* pMemory, const USize subPoolID) const noexcept;
     bool IsSkipListNodeByIDInSubPool(const USize idInSubPool, const USize subPoolID) const noexcept;
     void SetIsSkipListNode(const void* pMemory, const USize subPoolID, const bool isSkipListNode) noexcept;
@@ -363,41 +831,38 @@ private:
 
         KoPoolIteratorCore(const KoPoolIteratable& pool) noexcept {
 
-            const USize subPoolsWhichHaveAtLeastOneElement = pool._subPoolsWhichHaveAtLeastOneElement;
-            if (subPoolsWhichHaveAtLeastOneElement == 0) {
+            const USize subPoolID = FindSubPoolsMaskBit(pool._subPoolsWhichHaveAtLeastOneElement, 0);
+            if (subPoolID == SUB_POOL_ID_NONE) {
 
                 _subPoolID = SUBPOOLS_CNT - 1;
             }
             else {
 
-                _subPoolID = Count0BitsRight(subPoolsWhichHaveAtLeastOneElement);
+                _subPoolID = subPoolID;
                 _idInSubPool = 0;
+                _subPoolSize = GetSubPoolSize(pool._layout, subPoolID);
+                _subPoolBaseID = GetSubPoolBaseID(pool._layout, subPoolID);
             }
         }
 
-        template <typename T>
-        __KO_POOL_FORCE_INLINE__ const T* NextAbstract(const KoPoolIteratable& pool) noexcept {
-
-            __KO_POOL_ITERATABLE_ASSERT_TEST__(sizeof(T) <= pool._opt.elementSizeInBytes);
-            __KO_POOL_ITERATABLE_ASSERT_TEST__(alignof(T) == pool._opt.elementAlignment);
+        __KO_POOL_FORCE_INLINE__ const uint8_t* NextBytes(const KoPoolIteratable& pool) noexcept {
 
             __KO_POOL_ITERATABLE_ASSERT_TEST__(pool._pSubPools);
             const SubPools& subPools = *pool._pSubPools;
 
             for (;;) {
 
-                if (_idInSubPool >= GetSubPoolSize(_subPoolID)) {
+                if (_idInSubPool >= _subPoolSize) {
 
-                    const USize mask = static_cast<USize>(1) << _subPoolID;
-                    const USize subPoolsWhichHaveAtLeastOneElement =
-                        pool._subPoolsWhichHaveAtLeastOneElement & ~(mask | (mask - 1));
-
-                    if (subPoolsWhichHaveAtLeastOneElement == 0) {
+                    const USize subPoolID = FindSubPoolsMaskBit(pool._subPoolsWhichHaveAtLeastOneElement, _subPoolID + 1);
+                    if (subPoolID == SUB_POOL_ID_NONE) {
                         return nullptr;
                     }
 
-                    _subPoolID = Count0BitsRight(subPoolsWhichHaveAtLeastOneElement);
+                    _subPoolID = subPoolID;
                     _idInSubPool = 0;
+                    _subPoolSize = GetSubPoolSize(pool._layout, subPoolID);
+                    _subPoolBaseID = GetSubPoolBaseID(pool._layout, subPoolID);
                 }
 
                 const uint8_t* pMemory = subPools.pointers[_subPoolID];
@@ -407,7 +872,7 @@ private:
 
                 if (isSkipNode) {
 
-                    const USize size = GetSubPoolSize(_subPoolID);
+                    const USize size = _subPoolSize;
 
                     if (_idInSubPool + 1 == size) {
 
@@ -441,13 +906,22 @@ private:
                     }
                 }
 
-                const T* pResult = reinterpret_cast<const T*>(pMemory + _idInSubPool * pool._opt.elementSizeInBytes);
+                const uint8_t* pResult = pMemory + _idInSubPool * pool._opt.elementSizeInBytes;
                 _idInSubPool += 1;
 
                 return pResult;
             }
         }
 
+        template <typename T>
+        __KO_POOL_FORCE_INLINE__ const T* NextAbstract(const KoPoolIteratable& pool) noexcept {
+
+            __KO_POOL_ITERATABLE_ASSERT_TEST__(sizeof(T) <= pool._opt.elementSizeInBytes);
+            __KO_POOL_ITERATABLE_ASSERT_TEST__(alignof(T) == pool._opt.elementAlignment);
+
+            return reinterpret_cast<const T*>(NextBytes(pool));
+        }
+
         template <typename T>
         __KO_POOL_FORCE_INLINE__ const T* Next(const KoPoolIteratable& pool) noexcept {
 
@@ -459,18 +933,17 @@ private:
 
             for (;;) {
 
-                if (_idInSubPool >= GetSubPoolSize(_subPoolID)) {
+                if (_idInSubPool >= _subPoolSize) {
 
-                    const USize mask = static_cast<USize>(1) << _subPoolID;
-                    const USize subPoolsWhichHaveAtLeastOneElement =
-                        pool._subPoolsWhichHaveAtLeastOneElement & ~(mask | (mask - 1));
-
-                    if (subPoolsWhichHaveAtLeastOneElement == 0) {
+                    const USize subPoolID = FindSubPoolsMaskBit(pool._subPoolsWhichHaveAtLeastOneElement, _subPoolID + 1);
+                    if (subPoolID == SUB_POOL_ID_NONE) {
                         return nullptr;
                     }
 
-                    _subPoolID = Count0BitsRight(subPoolsWhichHaveAtLeastOneElement);
+                    _subPoolID = subPoolID;
                     _idInSubPool = 0;
+                    _subPoolSize = GetSubPoolSize(pool._layout, subPoolID);
+                    _subPoolBaseID = GetSubPoolBaseID(pool._layout, subPoolID);
                 }
 
                 const T* pMemory = reinterpret_cast<const T*>(subPools.pointers[_subPoolID]);
@@ -480,7 +953,7 @@ private:
 
                 if (isSkipNode) {
 
-                    const USize size = GetSubPoolSize(_subPoolID);
+                    const USize size = _subPoolSize;
 
                     if (_idInSubPool + 1 == size) {
 
@@ -528,13 +1001,12 @@ private:
 
             KoPoolIteratorCore iterator = *this;
 
-            __KO_POOL_ITERATABLE_ASSERT_TEST__(_subPoolID < KoPoolIteratable::DIGITS);
-            __KO_POOL_ITERATABLE_ASSERT_TEST__(IsPowerOf2(KoPoolIteratable::DIGITS));
+            __KO_POOL_ITERATABLE_ASSERT_TEST__(_subPoolID < KoPoolIteratable::SUBPOOLS_CNT);
 
             __KO_POOL_ITERATABLE_ASSERT_TEST__(pool._pSubPools);
             if (!pool._pSubPools->pointers[_subPoolID]) {
 
-                iterator._idInSubPool = GetSubPoolSize(_subPoolID);
+                iterator._idInSubPool = _subPoolSize;
                 return iterator;
             }
 
@@ -612,10 +1084,27 @@ private:
             return iterator;
         }
 
+        __KO_POOL_FORCE_INLINE__ USize GetSubPoolID() const noexcept {
+            return _subPoolID;
+        }
+
+        __KO_POOL_FORCE_INLINE__ USize GetIDInSubPool() const noexcept {
+            return _idInSubPool;
+        }
+
+        // Global ID of the element returned by the last 'Next...(...)'
+        __KO_POOL_FORCE_INLINE__ USize GetLastID() const noexcept {
+            return _subPoolBaseID + _idInSubPool - 1;
+        }
+
     private:
 
         USize _subPoolID = 0;
         USize _idInSubPool = std::numeric_limits<USize>::max();
+
+        // 'GetSubPoolSize(...)' and 'GetSubPoolBaseID(...)' of '_subPoolID'
+        USize _subPoolSize = 0;
+        USize _subPoolBaseID = 0;
     };
 
 private:
@@ -623,65 +1112,127 @@ private:
     template <typename T>
     friend class KoPoolIterator;
 
-    static constexpr USize DIGITS = SUBPOOLS_CNT;
+    template <typename ...Ts>
+    friend class KoPoolColumnsIterator;
+
+    friend class KoPoolRankIndex;
+
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+    friend class KoPoolInstrumentation;
+#endif
+
+    static constexpr USize DIGITS = std::numeric_limits<USize>::digits;
     static constexpr USize SUB_POOL_ID_NONE = SUBPOOLS_CNT;
 
     struct SubPools;
 
+    struct DeferredDeallocation {
+
+        uint8_t* pMemory = nullptr;
+
+        // 'nullptr' for the trivially destructible elements
+        void (*pDestroy)(void*) noexcept = nullptr;
+    };
+
     struct SubPoolsUniquePtrDeleter {
         void operator()(SubPools* ptr) const noexcept;
     };
 
+#ifdef __KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__
+
+    // Byte offset from the sub pool pointer
+    using SkipNodeOffset = uint32_t;
+    using SkipNodeSize = uint32_t;
+
+    static constexpr SkipNodeOffset SKIP_NODE_OFFSET_NONE = std::numeric_limits<SkipNodeOffset>::max();
+    static constexpr SkipNodeOffset SKIP_NODE_OFFSET_POOL = std::numeric_limits<SkipNodeOffset>::max() - 1;
+
     struct SkipNodeBase {
-        SkipNodeTail* pPrevFreeSkipNodeTail = nullptr;
+        SkipNodeOffset prevFreeSkipNodeTailOffset = SKIP_NODE_OFFSET_NONE;
     };
 
     struct SkipNodeHead : public SkipNodeBase {
-        uintptr_t numBytesToTail = 0;
+        SkipNodeSize numBytesToTail = 0;
     };
 
     struct SkipNodeTail : public SkipNodeBase {
-        SkipNodeBase* pNextFreeSkipNodeHead = nullptr;
+        SkipNodeOffset nextFreeSkipNodeHeadOffset = SKIP_NODE_OFFSET_NONE;
     };
 
-    struct SortedPointer {
+    SkipNodeBase* DecodeSkipNode(const SkipNodeOffset offset, const USize subPoolID) const noexcept;
+    SkipNodeOffset EncodeSkipNode(const SkipNodeBase* pNode, const USize subPoolID) const noexcept;
+#else
+
+    using SkipNodeSize = uintptr_t;
 
-        uint8_t* pMemory = nullptr;
-        USize subPoolID = SUB_POOL_ID_NONE;
+    struct SkipNodeBase {
+        SkipNodeTail* pPrevFreeSkipNodeTail = nullptr;
+    };
+
+    struct SkipNodeHead : public SkipNodeBase {
+        SkipNodeSize numBytesToTail = 0;
+    };
+
+    struct SkipNodeTail : public SkipNodeBase {
+        SkipNodeBase* pNextFreeSkipNodeHead = nullptr;
     };
+#endif
 
     struct SubPools {
 
-        // 'USize* pIsSkipListNode' is stored in 'pPrevFreeSkipNodeTail'
+        // The list head of the free skip nodes of the sub pool
         struct Pool : public SkipNodeTail {
 
-#ifdef __KO_POOL_ITERATABLE_DEV__
+            // Bit per element, 1 - skip list node
+            USize* pSkipBitmap = nullptr;
             USize numUsed = 0;
-#endif
         };
 
-        // sum(2^0...2^(DIGITS - 1)) == 2^DIGITS - 1, in 2^0 we store 2 elements see. 'GetSubPoolSize(...)'
-        std::array<Pool, DIGITS - 1> pools;
-        std::array<uint8_t*, DIGITS - 1> pointers{ nullptr };
+        // sum(2^0...2^(DIGITS - 1)) == 2^DIGITS - 1, in 2^0 we store 2 elements see. 'GetSubPoolSize(...)'.
+        // With 'Opt::maxSubPoolSize' the sub pools after the capped one have the same size,
+        // 'Opt::initialSubPoolSize' and 'Opt::growthFactor' change the sizes before it
+        std::array<Pool, SUBPOOLS_CNT - 1> pools;
+        std::array<uint8_t*, SUBPOOLS_CNT - 1> pointers{ nullptr };
 
-        std::array<SortedPointer, DIGITS - 1> sortedPointers{ SortedPointer{} };
+        // Sub pool pointers sorted by address and their sub pool IDs, the binary search reads only the pointers.
+        // The last one is always empty, the pow2 binary search reads up to 'SUBPOOLS_CNT' - 1
+        std::array<uint8_t*, SUBPOOLS_CNT> sortedPointers{ nullptr };
+        std::array<SubPoolIDSmall, SUBPOOLS_CNT> sortedSubPoolIDs{};
         USize sortedPointersSize = 0;
+
+        // Copy of the pool 'Opt', used to deallocate the sub pools in 'SubPoolsUniquePtrDeleter'
+        Opt opt;
+        Layout layout;
+
+        USize capacity = 0;
+        USize numBytesReserved = 0;
     };
 
     using SubPoolsUniquePtr = std::unique_ptr<SubPools, SubPoolsUniquePtrDeleter>;
 
     //static_assert(IsPowerOf2(DIGITS), "");
     static_assert(DIGITS != 0 && ((DIGITS & (DIGITS - 1)) == 0), "");
+    static_assert(SUBPOOLS_CNT >= 8 && SUBPOOLS_CNT < 65536 && ((SUBPOOLS_CNT & (SUBPOOLS_CNT - 1)) == 0), "");
     static_assert(sizeof(SkipNodeHead) == sizeof(SkipNodeTail), "");
+    static_assert(sizeof(SkipNodeHead) == MIN_ELEMENT_SIZE_IN_BYTES, "");
     static_assert(alignof(SkipNodeHead) == alignof(SkipNodeTail), "");
 
-    USize _vacantSubPools = std::numeric_limits<USize>::max();
-    USize _subPoolsWhichHaveAtLeastOneElement = 0;
+    SubPoolsMask _vacantSubPools = MakeSubPoolsMaskFull();
+    SubPoolsMask _subPoolsWhichHaveAtLeastOneElement{};
     USize _subPoolToDeallocate = SUB_POOL_ID_NONE;
+    USize _generation = 0;
 
     SubPoolsUniquePtr _pSubPools = nullptr;
 
+    // See 'DeallocateLater(...)'
+    std::vector<DeferredDeallocation> _deferredDeallocations;
+
     Opt _opt;
+    Layout _layout = MakeLayout(Opt{});
+
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+    mutable KoPoolInstrumentation _instrumentation;
+#endif
 };
 
 // Iterator can be invalidated, so use 'GetFixedIteratorAfterDeallocate(...)'
@@ -706,18 +1257,47 @@ public:
         return _core.NextAbstract<T>(*_pPool);
     }
 
-    template <typename U = T, std::enable_if_t<!std::is_abstract<U>::value>* = nullptr>
+    template <typename U = T, std::enable_if_t<!std::is_abstract<U>::value && !std::is_void<U>::value>* = nullptr>
     __KO_POOL_FORCE_INLINE__ T* Next() noexcept {
 
         return const_cast<T*>(_core.Next<T>(*_pPool));
     }
 
-    template <typename U = T, std::enable_if_t<!std::is_abstract<U>::value>* = nullptr>
+    template <typename U = T, std::enable_if_t<!std::is_abstract<U>::value && !std::is_void<U>::value>* = nullptr>
     __KO_POOL_FORCE_INLINE__ T* Next() const noexcept {
 
         return _core.Next<T>(*_pPool);
     }
 
+    template <typename U = T, std::enable_if_t<std::is_void<U>::value>* = nullptr>
+    __KO_POOL_FORCE_INLINE__ T* Next() noexcept {
+
+        return const_cast<uint8_t*>(_core.NextBytes(*_pPool));
+    }
+
+    struct NextExResult {
+
+        T* pData = nullptr;
+        KoPoolIteratable::USize id = 0;
+        KoPoolIteratable::USize subPoolID = KoPoolIteratable::SUB_POOL_ID_NONE;
+    };
+
+    // 'Next()' with the global ID and the sub pool ID of the element, which the iterator already knows,
+    // so the element can be deallocated by 'DeallocateBySubPoolID(...)'/'DeallocateByID(...)' without a search
+    __KO_POOL_FORCE_INLINE__ NextExResult NextEx() noexcept {
+
+        NextExResult result{};
+        result.pData = Next();
+
+        if (result.pData) {
+
+            result.id = _core.GetLastID();
+            result.subPoolID = _core.GetSubPoolID();
+        }
+
+        return result;
+    }
+
     // Must be called immediately after Deallocate...
     __KO_POOL_FORCE_INLINE__ KoPoolIterator GetFixedIteratorAfterDeallocate(
         const void* pDeallocatedMemory
@@ -736,3 +1316,63 @@ private:
     const KoPoolIteratable* _pPool = nullptr;
     KoPoolIteratable::KoPoolIteratorCore _core;
 };
+
+// Iterates one or more columns of the structure of arrays pool, see 'KoPoolIteratable::Opt::columnsCnt'.
+// Iterator can be invalidated like 'KoPoolIterator'
+template <typename ...Ts>
+class KoPoolColumnsIterator {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    KoPoolColumnsIterator(const KoPoolIteratable& pool, const std::array<USize, sizeof...(Ts)>& columnIDs) noexcept
+        : _pPool(&pool)
+        , _core(pool)
+        , _columnIDs(columnIDs)
+    {
+        for (USize i = 0; i < sizeof...(Ts); ++i) {
+
+            __KO_POOL_ITERATABLE_ASSERT_DEV__(columnIDs[i] < pool._opt.columnsCnt);
+            __KO_POOL_ITERATABLE_ASSERT_DEV__(_columnSizesInBytes[i] == pool._layout.columnSizesInBytes[columnIDs[i]]);
+        }
+    }
+
+    // Returns false when there are no more elements
+    __KO_POOL_FORCE_INLINE__ bool Next(Ts*&... pColumns) noexcept {
+
+        if (!_core.NextBytes(*_pPool)) {
+            return false;
+        }
+
+        if (_subPoolID != _core.GetSubPoolID()) {
+
+            _subPoolID = _core.GetSubPoolID();
+
+            const USize size = KoPoolIteratable::GetSubPoolSize(_pPool->_layout, _subPoolID);
+            uint8_t* pSubPool = _pPool->_pSubPools->pointers[_subPoolID];
+
+            for (USize i = 0; i < sizeof...(Ts); ++i) {
+                _columns[i] = pSubPool + size * _pPool->_layout.columnOffsetsInBytes[_columnIDs[i]];
+            }
+        }
+
+        // 'NextBytes' moves to the next ID
+        const USize idInSubPool = _core.GetIDInSubPool() - 1;
+
+        USize i = 0;
+        ((pColumns = reinterpret_cast<Ts*>(_columns[i] + idInSubPool * sizeof(Ts)), i += 1), ...);
+
+        return true;
+    }
+
+private:
+
+    static constexpr std::array<USize, sizeof...(Ts)> _columnSizesInBytes{ sizeof(Ts)... };
+
+    const KoPoolIteratable* _pPool = nullptr;
+    KoPoolIteratable::KoPoolIteratorCore _core;
+
+    std::array<USize, sizeof...(Ts)> _columnIDs{};
+    std::array<uint8_t*, sizeof...(Ts)> _columns{ nullptr };
+    USize _subPoolID = KoPoolIteratable::SUB_POOL_ID_NONE;
+};
@@ -0,0 +1,67 @@
+#include "KoPoolMemoryResource.h"
+#include "KoPoolMemoryUtils.h"
+
+namespace {
+
+    using KoPoolMemoryUtils::RoundUp;
+}
+
+KoPoolMemoryResource::KoPoolMemoryResource() noexcept
+    : KoPoolMemoryResource(Opt{})
+{}
+
+KoPoolMemoryResource::KoPoolMemoryResource(const Opt& opt) noexcept
+    : _pUpstream(opt.pUpstream ? opt.pUpstream : std::pmr::get_default_resource())
+    , _nodeSizeInBytes(opt.nodeSizeInBytes)
+    , _nodeAlignment(opt.nodeAlignment)
+{
+    KoPoolIteratable::Opt poolOpt{};
+    poolOpt.elementAlignment = std::max(opt.nodeAlignment, static_cast<USize>(alignof(uintptr_t)));
+
+    // Element size must be a multiple of the alignment, so every element inside of a sub pool is aligned
+    poolOpt.elementSizeInBytes = RoundUp(
+        std::max(opt.nodeSizeInBytes, KoPoolIteratable::MIN_ELEMENT_SIZE_IN_BYTES), poolOpt.elementAlignment
+    );
+
+    _pool = KoPoolIteratable{ poolOpt };
+}
+
+const KoPoolIteratable& KoPoolMemoryResource::GetPool() const noexcept {
+    return _pool;
+}
+
+std::pmr::memory_resource* KoPoolMemoryResource::GetUpstream() const noexcept {
+    return _pUpstream;
+}
+
+bool KoPoolMemoryResource::IsPoolRequest(const USize sizeInBytes, const USize alignment) const noexcept {
+    return sizeInBytes == _nodeSizeInBytes && alignment <= _nodeAlignment;
+}
+
+void* KoPoolMemoryResource::do_allocate(std::size_t sizeInBytes, std::size_t alignment) {
+
+    if (!IsPoolRequest(sizeInBytes, alignment)) {
+        return _pUpstream->allocate(sizeInBytes, alignment);
+    }
+
+    const KoPoolIteratable::AllocBytesResult alloc = _pool.AllocateBytes();
+    if (!alloc.pMemory) {
+        throw std::bad_alloc{};
+    }
+
+    return alloc.pMemory;
+}
+
+void KoPoolMemoryResource::do_deallocate(void* pMemory, std::size_t sizeInBytes, std::size_t alignment) {
+
+    if (!IsPoolRequest(sizeInBytes, alignment)) {
+        _pUpstream->deallocate(pMemory, sizeInBytes, alignment);
+        return;
+    }
+
+    _pool.DeallocateBytesByPtr(pMemory);
+}
+
+bool KoPoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory_resource>
+
+#include "KoPoolIteratable.h"
+
+// 'std::pmr::memory_resource' which serves fixed-size node allocations ('std::pmr::list', 'std::pmr::map',
+// 'std::pmr::unordered_map' nodes) from 'KoPoolIteratable', so nodes are stored densely with stable pointers
+// and can be iterated in memory order by 'GetPool()'. All other requests (e.g. bucket arrays of
+// 'std::pmr::unordered_map') are forwarded to the upstream resource. Not thread safe,
+// like 'std::pmr::unsynchronized_pool_resource'
+class KoPoolMemoryResource : public std::pmr::memory_resource {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    struct Opt {
+
+        // The node size is implementation defined, e.g. for 'std::pmr::list<T>' it is usually 'sizeof(T)' + 2 pointers
+        USize nodeSizeInBytes = KoPoolIteratable::MIN_ELEMENT_SIZE_IN_BYTES;
+        USize nodeAlignment = alignof(USize);
+
+        // 'nullptr' means 'std::pmr::get_default_resource()'
+        std::pmr::memory_resource* pUpstream = nullptr;
+    };
+
+    KoPoolMemoryResource() noexcept;
+    KoPoolMemoryResource(const Opt& opt) noexcept;
+
+    KoPoolMemoryResource(const KoPoolMemoryResource&) = delete;
+    KoPoolMemoryResource& operator=(const KoPoolMemoryResource&) = delete;
+
+    // Nodes are iteratable as elements of 'GetPool().GetOpt().elementSizeInBytes' bytes,
+    // the size can be greater than 'Opt::nodeSizeInBytes' because the pool needs >= 'MIN_ELEMENT_SIZE_IN_BYTES'
+    const KoPoolIteratable& GetPool() const noexcept;
+    std::pmr::memory_resource* GetUpstream() const noexcept;
+
+    bool IsPoolRequest(const USize sizeInBytes, const USize alignment) const noexcept;
+
+private:
+
+    void* do_allocate(std::size_t sizeInBytes, std::size_t alignment) override;
+    void do_deallocate(void* pMemory, std::size_t sizeInBytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+
+    KoPoolIteratable _pool;
+    std::pmr::memory_resource* _pUpstream = nullptr;
+
+    USize _nodeSizeInBytes = 0;
+    USize _nodeAlignment = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+// Internal helpers of the translation units, not a part of the interface
+namespace KoPoolMemoryUtils {
+
+    inline void* AlignedMalloc(const size_t sizeInBytes, const size_t alignment) noexcept {
+#if defined(_MSC_VER)
+        return _aligned_malloc(sizeInBytes, alignment);
+#else
+        return std::aligned_alloc(alignment, sizeInBytes);
+#endif
+    }
+
+    inline void AlignedFree(void* ptr) noexcept {
+#if defined(_MSC_VER)
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    inline size_t RoundUp(const size_t x, const size_t alignment) noexcept {
+        return (x + alignment - 1) & ~(alignment - 1);
+    }
+}
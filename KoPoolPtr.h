@@ -0,0 +1,275 @@
+#pragma once
+
+#include <utility>
+#include <type_traits>
+
+#include "KoPoolIteratable.h"
+
+// Owning pointer to an element of a pool. The sub pool ID is captured from 'AllocBytesResult' on allocation
+// and the element is freed by 'DeallocateBySubPoolID(...)', so the release doesn't binary search the sub pool
+// of the pointer like 'Deallocate(...)'. The pool must outlive the pointer. Create by 'KoPoolMakeUnique<T>(...)'
+template <typename T>
+class KoPoolUniquePtr {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    KoPoolUniquePtr() noexcept = default;
+
+    KoPoolUniquePtr(KoPoolIteratable& pool, T* pData, const USize subPoolID) noexcept
+        : _pPool(&pool)
+        , _pData(pData)
+        , _subPoolID(subPoolID)
+    {}
+
+    ~KoPoolUniquePtr() noexcept(std::is_nothrow_destructible_v<T>) {
+        Reset();
+    }
+
+    KoPoolUniquePtr(const KoPoolUniquePtr&) = delete;
+    KoPoolUniquePtr& operator=(const KoPoolUniquePtr&) = delete;
+
+    KoPoolUniquePtr(KoPoolUniquePtr&& other) noexcept
+        : _pPool(other._pPool)
+        , _pData(std::exchange(other._pData, nullptr))
+        , _subPoolID(other._subPoolID)
+    {}
+
+    KoPoolUniquePtr& operator=(KoPoolUniquePtr&& other) noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if (this != &other) {
+
+            Reset();
+
+            _pPool = other._pPool;
+            _pData = std::exchange(other._pData, nullptr);
+            _subPoolID = other._subPoolID;
+        }
+
+        return *this;
+    }
+
+    void Reset() noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if (_pData) {
+            _pPool->DeallocateBySubPoolID(std::exchange(_pData, nullptr), _subPoolID);
+        }
+    }
+
+    // The caller owns the element, e.g. to free it by 'DeallocateBySubPoolID(...)' with 'GetSubPoolID()'
+    T* Release() noexcept {
+        return std::exchange(_pData, nullptr);
+    }
+
+    T* Get() const noexcept {
+        return _pData;
+    }
+
+    USize GetSubPoolID() const noexcept {
+        return _subPoolID;
+    }
+
+    KoPoolIteratable* GetPool() const noexcept {
+        return _pPool;
+    }
+
+    T& operator*() const noexcept {
+        return *_pData;
+    }
+
+    T* operator->() const noexcept {
+        return _pData;
+    }
+
+    explicit operator bool() const noexcept {
+        return _pData;
+    }
+
+private:
+
+    KoPoolIteratable* _pPool = nullptr;
+    T* _pData = nullptr;
+    USize _subPoolID = 0;
+};
+
+// Empty when the pool can't allocate
+template <typename T, typename ...Args>
+KoPoolUniquePtr<T> KoPoolMakeUnique(KoPoolIteratable& pool, Args&&... args) {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(sizeof(T) == pool.GetOpt().elementSizeInBytes);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(alignof(T) == pool.GetOpt().elementAlignment);
+
+    const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+    if (!alloc.pMemory) {
+        return KoPoolUniquePtr<T>{};
+    }
+
+    T* pData = new (alloc.pMemory) T{ std::forward<Args>(args)... };
+
+    return KoPoolUniquePtr<T>{ pool, pData, alloc.subPoolID };
+}
+
+template <typename T>
+class KoPoolRefPtr;
+
+// Base of the elements owned by 'KoPoolRefPtr<T>', the reference count and the sub pool ID are stored
+// in the element, so the pointer is the pool and the element. Not thread safe, like the pool
+class KoPoolRefCounted {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    KoPoolRefCounted() noexcept = default;
+
+    // A copy of the element starts unreferenced, its sub pool ID is set by 'KoPoolMakeRef<T>(...)'
+    KoPoolRefCounted(const KoPoolRefCounted&) noexcept {}
+
+    KoPoolRefCounted& operator=(const KoPoolRefCounted&) noexcept {
+        return *this;
+    }
+
+    USize GetNumRefs() const noexcept {
+        return _numRefs;
+    }
+
+private:
+
+    template <typename T>
+    friend class KoPoolRefPtr;
+
+    template <typename T, typename ...Args>
+    friend KoPoolRefPtr<T> KoPoolMakeRef(KoPoolIteratable& pool, Args&&... args);
+
+    USize _numRefs = 0;
+    USize _subPoolID = 0;
+};
+
+// Intrusive reference counted pointer to an element of a pool, 'T' derives from 'KoPoolRefCounted'.
+// The last reference frees the element by 'DeallocateBySubPoolID(...)'. The pool must outlive the pointers.
+// Create by 'KoPoolMakeRef<T>(...)'
+template <typename T>
+class KoPoolRefPtr {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    KoPoolRefPtr() noexcept = default;
+
+    KoPoolRefPtr(KoPoolIteratable& pool, T* pData) noexcept
+        : _pPool(&pool)
+        , _pData(pData)
+    {
+        static_assert(std::is_base_of_v<KoPoolRefCounted, T>, "");
+        AddRef();
+    }
+
+    ~KoPoolRefPtr() noexcept(std::is_nothrow_destructible_v<T>) {
+        Reset();
+    }
+
+    KoPoolRefPtr(const KoPoolRefPtr& other) noexcept
+        : _pPool(other._pPool)
+        , _pData(other._pData)
+    {
+        AddRef();
+    }
+
+    KoPoolRefPtr& operator=(const KoPoolRefPtr& other) noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if (_pData != other._pData) {
+
+            // Referenced first, 'other' can be owned by the element which 'Reset()' frees
+            KoPoolRefPtr copy{ other };
+            *this = std::move(copy);
+        }
+
+        return *this;
+    }
+
+    KoPoolRefPtr(KoPoolRefPtr&& other) noexcept
+        : _pPool(other._pPool)
+        , _pData(std::exchange(other._pData, nullptr))
+    {}
+
+    KoPoolRefPtr& operator=(KoPoolRefPtr&& other) noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if (this != &other) {
+
+            Reset();
+
+            _pPool = other._pPool;
+            _pData = std::exchange(other._pData, nullptr);
+        }
+
+        return *this;
+    }
+
+    void Reset() noexcept(std::is_nothrow_destructible_v<T>) {
+
+        T* pData = std::exchange(_pData, nullptr);
+        if (!pData) {
+            return;
+        }
+
+        KoPoolRefCounted& refCounted = *pData;
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(refCounted._numRefs > 0);
+
+        refCounted._numRefs -= 1;
+
+        if (refCounted._numRefs == 0) {
+            _pPool->DeallocateBySubPoolID(pData, refCounted._subPoolID);
+        }
+    }
+
+    T* Get() const noexcept {
+        return _pData;
+    }
+
+    KoPoolIteratable* GetPool() const noexcept {
+        return _pPool;
+    }
+
+    T& operator*() const noexcept {
+        return *_pData;
+    }
+
+    T* operator->() const noexcept {
+        return _pData;
+    }
+
+    explicit operator bool() const noexcept {
+        return _pData;
+    }
+
+private:
+
+    void AddRef() noexcept {
+
+        if (_pData) {
+            static_cast<KoPoolRefCounted&>(*_pData)._numRefs += 1;
+        }
+    }
+
+private:
+
+    KoPoolIteratable* _pPool = nullptr;
+    T* _pData = nullptr;
+};
+
+// Empty when the pool can't allocate
+template <typename T, typename ...Args>
+KoPoolRefPtr<T> KoPoolMakeRef(KoPoolIteratable& pool, Args&&... args) {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(sizeof(T) == pool.GetOpt().elementSizeInBytes);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(alignof(T) == pool.GetOpt().elementAlignment);
+
+    const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+    if (!alloc.pMemory) {
+        return KoPoolRefPtr<T>{};
+    }
+
+    T* pData = new (alloc.pMemory) T{ std::forward<Args>(args)... };
+    static_cast<KoPoolRefCounted&>(*pData)._subPoolID = alloc.subPoolID;
+
+    return KoPoolRefPtr<T>{ pool, pData };
+}
@@ -0,0 +1,158 @@
+#include "KoPoolRankIndex.h"
+
+#include <algorithm>
+
+KoPoolRankIndex::KoPoolRankIndex(const KoPoolIteratable& pool) noexcept
+    : _pPool(&pool)
+{}
+
+void KoPoolRankIndex::Update() {
+
+    if (!IsStale()) {
+        return;
+    }
+
+    const KoPoolIteratable& pool = *_pPool;
+
+    _blockRanks.clear();
+    _firstBlockIDs.fill(BLOCK_ID_NONE);
+
+    USize rank = 0;
+
+    // Sub pools in ID order, their base IDs grow with the sub pool ID
+    for (USize subPoolID = 0; subPoolID < static_cast<USize>(_subPoolRanks.size()); ++subPoolID) {
+
+        _subPoolRanks[subPoolID] = rank;
+
+        if (!pool._pSubPools || pool._pSubPools->pools[subPoolID].numUsed == 0) {
+            continue;
+        }
+
+        const USize* pSkipBitmap = pool._pSubPools->pools[subPoolID].pSkipBitmap;
+        const USize numWords = (KoPoolIteratable::GetSubPoolSize(pool._layout, subPoolID) + DIGITS - 1) / DIGITS;
+
+        _firstBlockIDs[subPoolID] = _blockRanks.size();
+
+        for (USize wordID = 0; wordID < numWords; ++wordID) {
+
+            if (wordID % BLOCK_WORDS == 0) {
+                _blockRanks.push_back(rank);
+            }
+
+            // 1 - skip node, the bits after the sub pool size are 1
+            rank += KoPoolIteratable::CountSetBits(~pSkipBitmap[wordID]);
+        }
+
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(rank - _subPoolRanks[subPoolID] == pool._pSubPools->pools[subPoolID].numUsed);
+    }
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(rank == pool.Size());
+
+    _generation = pool.GetGeneration();
+    _size = rank;
+    _isBuilt = true;
+}
+
+bool KoPoolRankIndex::IsStale() const noexcept {
+    return !_isBuilt || _generation != _pPool->GetGeneration() || _size != _pPool->Size();
+}
+
+void KoPoolRankIndex::Invalidate() noexcept {
+    _isBuilt = false;
+}
+
+KoPoolRankIndex::USize KoPoolRankIndex::Size() const noexcept {
+    return _pPool->Size();
+}
+
+bool KoPoolRankIndex::IsEmpty() const noexcept {
+    return _pPool->IsEmpty();
+}
+
+KoPoolRankIndex::USize KoPoolRankIndex::NthLive(const USize rank) {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(rank < Size());
+
+    Update();
+
+    const KoPoolIteratable& pool = *_pPool;
+
+    // The last sub pool and then the last block which start at or before 'rank', they have an allocated element,
+    // the ones without them have the rank of the next one
+    const auto itSubPool = std::upper_bound(_subPoolRanks.begin(), _subPoolRanks.end(), rank);
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(itSubPool != _subPoolRanks.begin());
+
+    const USize subPoolID = static_cast<USize>(itSubPool - _subPoolRanks.begin()) - 1;
+    const USize subPoolSize = KoPoolIteratable::GetSubPoolSize(pool._layout, subPoolID);
+    const USize numWords = (subPoolSize + DIGITS - 1) / DIGITS;
+
+    const USize firstBlockID = _firstBlockIDs[subPoolID];
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(firstBlockID != BLOCK_ID_NONE);
+
+    const auto itBlocksBegin = _blockRanks.begin() + firstBlockID;
+    const auto itBlock = std::upper_bound(itBlocksBegin, itBlocksBegin + (numWords + BLOCK_WORDS - 1) / BLOCK_WORDS, rank);
+
+    const USize blockID = static_cast<USize>(itBlock - itBlocksBegin) - 1;
+    USize rankInBlock = rank - *(itBlock - 1);
+
+    const USize* pSkipBitmap = pool._pSubPools->pools[subPoolID].pSkipBitmap;
+
+    for (USize wordID = blockID * BLOCK_WORDS; wordID < numWords; ++wordID) {
+
+        USize liveBits = ~pSkipBitmap[wordID];
+        const USize numLive = KoPoolIteratable::CountSetBits(liveBits);
+
+        if (rankInBlock >= numLive) {
+
+            rankInBlock -= numLive;
+            continue;
+        }
+
+        // Select the 'rankInBlock' set bit by halving the word
+        USize bitID = 0;
+
+        for (USize width = DIGITS / 2; width != 0; width /= 2) {
+
+            const USize numLow = KoPoolIteratable::CountSetBits(liveBits & ((static_cast<USize>(1) << width) - 1));
+
+            if (rankInBlock >= numLow) {
+
+                rankInBlock -= numLow;
+                liveBits >>= width;
+                bitID += width;
+            }
+        }
+
+        __KO_POOL_ITERATABLE_ASSERT_TEST__(rankInBlock == 0 && (liveBits & 1) != 0);
+
+        return KoPoolIteratable::GetSubPoolBaseID(pool._layout, subPoolID) + wordID * DIGITS + bitID;
+    }
+
+    __KO_POOL_UNREACHABLE__();
+    return ID_NONE;
+}
+
+KoPoolRankIndex::USize KoPoolRankIndex::RankOf(const USize id) {
+
+    Update();
+
+    const KoPoolIteratable& pool = *_pPool;
+
+    const USize subPoolID = pool.IDToSubPoolID(id);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(subPoolID < _firstBlockIDs.size() && _firstBlockIDs[subPoolID] != BLOCK_ID_NONE);
+
+    const USize idInSubPool = id - KoPoolIteratable::GetSubPoolBaseID(pool._layout, subPoolID);
+    const USize wordID = idInSubPool / DIGITS;
+    const USize bitID = idInSubPool & (DIGITS - 1);
+
+    const USize* pSkipBitmap = pool._pSubPools->pools[subPoolID].pSkipBitmap;
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(((pSkipBitmap[wordID] >> bitID) & 1) == 0);
+
+    USize rank = _blockRanks[_firstBlockIDs[subPoolID] + wordID / BLOCK_WORDS];
+
+    for (USize blockWordID = wordID - wordID % BLOCK_WORDS; blockWordID < wordID; ++blockWordID) {
+        rank += KoPoolIteratable::CountSetBits(~pSkipBitmap[blockWordID]);
+    }
+
+    return rank + KoPoolIteratable::CountSetBits(~pSkipBitmap[wordID] & ((static_cast<USize>(1) << bitID) - 1));
+}
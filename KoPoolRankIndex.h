@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <random>
+
+#include "KoPoolIteratable.h"
+
+// Rank/select index over the allocated elements of a pool: the elements in ID order get the dense ranks
+// 0...'Size()' - 1, e.g. to export them into arrays or to sample them uniformly. The index reads the skip bit sets
+// of the pool and stores only a directory: the count of the allocated elements before each sub pool and before
+// each block of 'BLOCK_WORDS' bit set words. 'RankOf(...)' is O(1), 'NthLive(...)' is a binary search over
+// the sub pools and the blocks. The first query after 'Size()' or the sub pools of the pool change
+// ('KoPoolIteratable::GetGeneration()') rebuilds the directory, O(number of the bit set words). The pool doesn't
+// count each allocation and deallocation, so after the ones which keep both, e.g. a deallocation followed by
+// an allocation, call 'Invalidate()'. The pool must outlive the index and stay in place
+class KoPoolRankIndex {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    static constexpr USize ID_NONE = std::numeric_limits<USize>::max();
+
+    // A word of the directory per 'BLOCK_WORDS' * 'digits(USize)' elements
+    static constexpr USize BLOCK_WORDS = 8;
+
+    explicit KoPoolRankIndex(const KoPoolIteratable& pool) noexcept;
+
+    // Rebuilds the directory if the pool changed since the last build, the queries call it
+    void Update();
+    bool IsStale() const noexcept;
+
+    // The next query rebuilds the directory
+    void Invalidate() noexcept;
+
+    // Number of the allocated elements
+    USize Size() const noexcept;
+    bool IsEmpty() const noexcept;
+
+    // ID of the element of 'rank' < 'Size()'
+    USize NthLive(const USize rank);
+
+    // Rank of the allocated element 'id'
+    USize RankOf(const USize id);
+
+    // ID of a uniformly random allocated element, 'ID_NONE' if empty
+    template <typename Rng>
+    USize SampleUniform(Rng& rng) {
+
+        const USize size = Size();
+        if (size == 0) {
+            return ID_NONE;
+        }
+
+        std::uniform_int_distribution<USize> distribution{ 0, size - 1 };
+        return NthLive(distribution(rng));
+    }
+
+private:
+
+    static constexpr USize DIGITS = std::numeric_limits<USize>::digits;
+    static constexpr USize BLOCK_ID_NONE = std::numeric_limits<USize>::max();
+
+    const KoPoolIteratable* _pPool = nullptr;
+
+    // Allocated elements before the sub pool, the sub pools without elements have the rank of the next one
+    std::array<USize, KoPoolIteratable::SUBPOOLS_CNT - 1> _subPoolRanks{};
+
+    // Index of the first block of the sub pool in '_blockRanks', 'BLOCK_ID_NONE' if the sub pool has no elements
+    std::array<USize, KoPoolIteratable::SUBPOOLS_CNT - 1> _firstBlockIDs{};
+
+    // Allocated elements before the block
+    std::vector<USize> _blockRanks;
+
+    // 'KoPoolIteratable::GetGeneration()' and 'KoPoolIteratable::Size()' of the build
+    USize _generation = 0;
+    USize _size = 0;
+    bool _isBuilt = false;
+};
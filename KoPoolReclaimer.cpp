@@ -0,0 +1,123 @@
+#include "KoPoolReclaimer.h"
+
+#include <utility>
+
+KoPoolReclaimer::KoPoolReclaimer()
+    : KoPoolReclaimer(Opt{})
+{}
+
+KoPoolReclaimer::KoPoolReclaimer(const Opt& opt)
+    : _opt(opt)
+{
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(_opt.numPendingReserved > 0);
+    _pending.reserve(_opt.numPendingReserved);
+    _released.reserve(_opt.numPendingReserved);
+
+    if (_opt.isBackgroundThread) {
+        _thread = std::thread{ [this]() { RunBackgroundThread(); } };
+    }
+}
+
+KoPoolReclaimer::~KoPoolReclaimer() noexcept {
+
+    if (_thread.joinable()) {
+
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            _isStopping = true;
+        }
+
+        _condition.notify_one();
+        _thread.join();
+    }
+
+    for (const KoPoolIteratable::ReleasedSubPool& releasedSubPool : _pending) {
+        KoPoolIteratable::FreeReleasedSubPool(releasedSubPool);
+    }
+}
+
+KoPoolIteratable::SubPoolReclaimer KoPoolReclaimer::GetSubPoolReclaimer() noexcept {
+
+    KoPoolIteratable::SubPoolReclaimer subPoolReclaimer{};
+    subPoolReclaimer.pReclaim = &KoPoolReclaimer::Reclaim;
+    subPoolReclaimer.pUserData = this;
+
+    return subPoolReclaimer;
+}
+
+KoPoolReclaimer::USize KoPoolReclaimer::ReleasePending() noexcept {
+
+    // The background thread and the user can drain at the same time, '_released' is used by one of them
+    std::lock_guard<std::mutex> releaseLock{ _releaseMutex };
+
+    USize numBytesReleased = 0;
+
+    {
+        std::lock_guard<std::mutex> lock{ _mutex };
+
+        if (_pending.empty()) {
+            return 0;
+        }
+
+        // '_released' is empty with the reserved capacity, so 'Reclaim(...)' doesn't allocate after the swap
+        _pending.swap(_released);
+        numBytesReleased = std::exchange(_numBytesPending, 0);
+    }
+
+    // Outside of the lock, the pools can release more sub pools meanwhile
+    for (const KoPoolIteratable::ReleasedSubPool& releasedSubPool : _released) {
+        KoPoolIteratable::FreeReleasedSubPool(releasedSubPool);
+    }
+
+    // Keeps the capacity
+    _released.clear();
+
+    return numBytesReleased;
+}
+
+KoPoolReclaimer::USize KoPoolReclaimer::GetNumPending() const noexcept {
+
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _pending.size();
+}
+
+KoPoolReclaimer::USize KoPoolReclaimer::GetNumBytesPending() const noexcept {
+
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _numBytesPending;
+}
+
+void KoPoolReclaimer::Reclaim(void* pUserData, const KoPoolIteratable::ReleasedSubPool& releasedSubPool) noexcept {
+
+    KoPoolReclaimer& reclaimer = *reinterpret_cast<KoPoolReclaimer*>(pUserData);
+
+    {
+        std::lock_guard<std::mutex> lock{ reclaimer._mutex };
+
+        // 'push_back(...)' doesn't allocate below the capacity
+        if (reclaimer._pending.size() < reclaimer._pending.capacity()) {
+
+            reclaimer._pending.push_back(releasedSubPool);
+            reclaimer._numBytesPending += releasedSubPool.sizeInBytes;
+
+            return;
+        }
+    }
+
+    // The queue is full, freed synchronously like without the reclaimer
+    KoPoolIteratable::FreeReleasedSubPool(releasedSubPool);
+}
+
+void KoPoolReclaimer::RunBackgroundThread() {
+
+    std::unique_lock<std::mutex> lock{ _mutex };
+
+    while (!_isStopping) {
+
+        _condition.wait_for(lock, _opt.period, [this]() { return _isStopping; });
+
+        lock.unlock();
+        ReleasePending();
+        lock.lock();
+    }
+}
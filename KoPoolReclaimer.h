@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "KoPoolIteratable.h"
+
+// Queue of the sub pools released by pools, see 'KoPoolIteratable::Opt::subPoolReclaimer'. The memory is freed
+// by 'ReleasePending()' or by the background thread, so no single 'Deallocate...()' pays the free/unmap of a large
+// sub pool. One reclaimer can serve many pools, the queue is thread safe. 'BlockAllocator::pDeallocate'
+// of the pools is called from the thread which drains the queue. Must outlive the pools
+class KoPoolReclaimer {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    struct Opt {
+
+        // Drains the queue every 'period'
+        bool isBackgroundThread = false;
+        std::chrono::milliseconds period{ 10 };
+
+        // Capacity of the queue, reserved, so a release doesn't allocate. The sub pools released
+        // when the queue is full are freed synchronously by 'Deallocate...()'
+        USize numPendingReserved = 64;
+    };
+
+    KoPoolReclaimer();
+    KoPoolReclaimer(const Opt& opt);
+
+    // Stops the background thread and frees all pending sub pools
+    ~KoPoolReclaimer() noexcept;
+
+    // Pools store pointers to the reclaimer
+    KoPoolReclaimer(const KoPoolReclaimer&) = delete;
+    KoPoolReclaimer& operator=(const KoPoolReclaimer&) = delete;
+
+    // Set it to 'KoPoolIteratable::Opt::subPoolReclaimer'
+    KoPoolIteratable::SubPoolReclaimer GetSubPoolReclaimer() noexcept;
+
+    // Frees all pending sub pools, returns the number of freed bytes. Doesn't allocate
+    USize ReleasePending() noexcept;
+
+    USize GetNumPending() const noexcept;
+    USize GetNumBytesPending() const noexcept;
+
+private:
+
+    static void Reclaim(void* pUserData, const KoPoolIteratable::ReleasedSubPool& releasedSubPool) noexcept;
+
+    void RunBackgroundThread();
+
+private:
+
+    Opt _opt;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+
+    std::vector<KoPoolIteratable::ReleasedSubPool> _pending;
+    USize _numBytesPending = 0;
+
+    // Swapped with '_pending' by 'ReleasePending()', both keep the reserved capacity.
+    // '_releaseMutex' is held by the drain, so the pools don't wait for the frees
+    std::mutex _releaseMutex;
+    std::vector<KoPoolIteratable::ReleasedSubPool> _released;
+
+    bool _isStopping = false;
+    std::thread _thread;
+};
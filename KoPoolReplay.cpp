@@ -0,0 +1,169 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <limits>
+
+#include "KoPoolTrace.h"
+
+// Replays a trace written by 'KoPoolTrace::Recorder' against a pool configured by the command line
+// and reports the time of each operation and the peak memory.
+// Usage: KoPoolReplay <trace> [options], see 'PrintUsage(...)'
+
+static void PrintUsage(const char* pName) {
+
+    fprintf(stderr, "Usage: %s <trace> [options]\n", pName);
+    fprintf(stderr, "  --element-size N        'Opt::elementSizeInBytes', the recorded one by default\n");
+    fprintf(stderr, "  --alignment N           'Opt::elementAlignment', the recorded one by default\n");
+    fprintf(stderr, "  --column SIZE:ALIGN     Appends a column, see 'Opt::columnsCnt', repeatable\n");
+    fprintf(stderr, "  --max-sub-pool-size N   'Opt::maxSubPoolSize'\n");
+    fprintf(stderr, "  --initial-sub-pool-size N\n");
+    fprintf(stderr, "                          'Opt::initialSubPoolSize'\n");
+    fprintf(stderr, "  --growth-factor N       'Opt::growthFactor'\n");
+    fprintf(stderr, "  --page-mapped-sub-pool-size N\n");
+    fprintf(stderr, "                          'Opt::pageMappedSubPoolSizeInBytes'\n");
+    fprintf(stderr, "  --colocated-skip-bitmap 'Opt::isSkipBitmapColocated'\n");
+}
+
+using USize = KoPoolIteratable::USize;
+
+// Decimal digits up to 'pEnd', 'false' on a sign, a missing number or an overflow of 'USize'
+static bool ParseUSize(const char* pText, const char*& pEnd, USize& value) {
+
+    if (*pText < '0' || *pText > '9') {
+        return false;
+    }
+
+    errno = 0;
+
+    char* pParsedEnd = nullptr;
+    const unsigned long long parsed = std::strtoull(pText, &pParsedEnd, 10);
+
+    if (errno == ERANGE || parsed > std::numeric_limits<USize>::max()) {
+        return false;
+    }
+
+    pEnd = pParsedEnd;
+    value = static_cast<USize>(parsed);
+
+    return true;
+}
+
+// The whole 'pText' is the number
+static bool ParseUSize(const char* pText, USize& value) {
+
+    const char* pEnd = nullptr;
+    return ParseUSize(pText, pEnd, value) && *pEnd == '\0';
+}
+
+static bool IsPowerOf2(const USize x) {
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const char* pPath = argv[1];
+
+    // Zero means the recorded value
+    KoPoolIteratable::Opt opt{};
+    opt.elementSizeInBytes = 0;
+    opt.elementAlignment = 0;
+
+    for (int i = 2; i < argc; ++i) {
+
+        const bool hasValue = i + 1 < argc;
+
+        // The checks of 'KoPoolIteratable::KoPoolIteratable(...)', zero element size/alignment is the recorded one
+        bool isValid = true;
+
+        if (hasValue && std::strcmp(argv[i], "--element-size") == 0) {
+
+            isValid =
+                ParseUSize(argv[++i], opt.elementSizeInBytes) &&
+                (opt.elementSizeInBytes == 0 || opt.elementSizeInBytes >= KoPoolIteratable::MIN_ELEMENT_SIZE_IN_BYTES);
+        }
+        else if (hasValue && std::strcmp(argv[i], "--alignment") == 0) {
+
+            isValid =
+                ParseUSize(argv[++i], opt.elementAlignment) &&
+                (opt.elementAlignment == 0 || IsPowerOf2(opt.elementAlignment));
+        }
+        else if (hasValue && std::strcmp(argv[i], "--column") == 0 && opt.columnsCnt < KoPoolIteratable::COLUMNS_CNT_MAX) {
+
+            const char* pEnd = nullptr;
+            USize sizeInBytes = 0;
+            USize alignment = 0;
+
+            isValid =
+                ParseUSize(argv[++i], pEnd, sizeInBytes) && *pEnd == ':' && ParseUSize(pEnd + 1, alignment) &&
+                sizeInBytes != 0 && IsPowerOf2(alignment) && sizeInBytes % alignment == 0;
+
+            opt.columnSizesInBytes[opt.columnsCnt] = sizeInBytes;
+            opt.columnAlignments[opt.columnsCnt] = alignment;
+            opt.columnsCnt += 1;
+        }
+        else if (hasValue && std::strcmp(argv[i], "--max-sub-pool-size") == 0) {
+
+            isValid =
+                ParseUSize(argv[++i], opt.maxSubPoolSize) &&
+                (opt.maxSubPoolSize == 0 || (IsPowerOf2(opt.maxSubPoolSize) && opt.maxSubPoolSize >= 2));
+        }
+        else if (hasValue && std::strcmp(argv[i], "--initial-sub-pool-size") == 0) {
+
+            isValid =
+                ParseUSize(argv[++i], opt.initialSubPoolSize) &&
+                IsPowerOf2(opt.initialSubPoolSize) && opt.initialSubPoolSize >= 2;
+        }
+        else if (hasValue && std::strcmp(argv[i], "--growth-factor") == 0) {
+            isValid = ParseUSize(argv[++i], opt.growthFactor) && IsPowerOf2(opt.growthFactor) && opt.growthFactor >= 2;
+        }
+        else if (hasValue && std::strcmp(argv[i], "--page-mapped-sub-pool-size") == 0) {
+            isValid = ParseUSize(argv[++i], opt.pageMappedSubPoolSizeInBytes);
+        }
+        else if (std::strcmp(argv[i], "--colocated-skip-bitmap") == 0) {
+            opt.isSkipBitmapColocated = true;
+        }
+        else {
+            isValid = false;
+        }
+
+        if (!isValid) {
+
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (opt.maxSubPoolSize != 0 && opt.maxSubPoolSize < opt.initialSubPoolSize) {
+
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const KoPoolTrace::ReplayResult result = KoPoolTrace::Replay(pPath, opt);
+
+    printf("Events:              %llu\n", static_cast<unsigned long long>(result.numEvents));
+    printf("Allocations:         %llu\n", static_cast<unsigned long long>(result.numAllocations));
+    printf("Deallocations:       %llu\n", static_cast<unsigned long long>(result.numDeallocations));
+    printf("Iterations:          %llu\n", static_cast<unsigned long long>(result.numIterations));
+    printf("Traced:              %fs\n", result.tracedSeconds);
+    printf("Allocate:            %fs\n", result.allocateSeconds);
+    printf("Deallocate:          %fs\n", result.deallocateSeconds);
+    printf("Iterate:             %fs\n", result.iterateSeconds);
+    printf("Peak Size:           %zu\n", static_cast<size_t>(result.peakSize));
+    printf("Peak Bytes Reserved: %zu\n", static_cast<size_t>(result.peakBytesReserved));
+
+    if (!result.isOk) {
+
+        fprintf(stderr, "Replay of '%s' failed: the file can't be read, the options don't fit or the trace is corrupted\n", pPath);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,401 @@
+#include "KoPoolTrace.h"
+
+#include <chrono>
+
+namespace {
+
+    inline uint64_t NowNs() noexcept {
+
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count()
+        );
+    }
+
+    inline void WriteVarUInt(std::vector<uint8_t>& buffer, uint64_t value) {
+
+        while (value >= 0x80) {
+
+            buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+}
+
+KoPoolTrace::Recorder::Recorder(KoPoolIteratable& pool, const char* pPath) noexcept
+    : _pPool(&pool)
+    , _pFile(fopen(pPath, "wb"))
+    , _startNs(NowNs())
+{
+    if (!_pFile) {
+        return;
+    }
+
+    _buffer.reserve(BUFFER_SIZE_IN_BYTES + 32);
+
+    Header header{};
+    header.elementSizeInBytes = pool.GetOpt().elementSizeInBytes;
+    header.elementAlignment = pool.GetOpt().elementAlignment;
+
+    if (fwrite(&header, sizeof(header), 1, _pFile) != 1) {
+
+        fclose(_pFile);
+        _pFile = nullptr;
+    }
+}
+
+KoPoolTrace::Recorder::~Recorder() noexcept {
+
+    if (!_pFile) {
+        return;
+    }
+
+    Flush();
+    fclose(_pFile);
+}
+
+bool KoPoolTrace::Recorder::IsOpen() const noexcept {
+    return _pFile;
+}
+
+KoPoolIteratable::AllocBytesResult KoPoolTrace::Recorder::AllocateBytes() noexcept {
+
+    const KoPoolIteratable::AllocBytesResult alloc = _pPool->AllocateBytes();
+
+    if (alloc.pMemory) {
+        Record(EventType::Allocate, alloc.id);
+    }
+
+    return alloc;
+}
+
+void KoPoolTrace::Recorder::DeallocateBytesByPtr(void* pMemory) noexcept {
+
+    if (!pMemory) {
+        return;
+    }
+
+    DeallocateBytesByPtrAndSubPoolID(pMemory, _pPool->FindSubPoolIDByPtr(pMemory));
+}
+
+void KoPoolTrace::Recorder::DeallocateBytesByPtrAndSubPoolID(void* pMemory, const USize subPoolID) noexcept {
+
+    if (!pMemory) {
+        return;
+    }
+
+    Record(EventType::Deallocate, _pPool->PtrToID(pMemory, subPoolID));
+    _pPool->DeallocateBytesByPtrAndSubPoolID(pMemory, subPoolID);
+}
+
+void KoPoolTrace::Recorder::DeallocateBytesByID(const USize id) noexcept {
+
+    Record(EventType::Deallocate, id);
+    _pPool->DeallocateBytesByID(id);
+}
+
+void KoPoolTrace::Recorder::RecordAllocate(const USize id) noexcept {
+    Record(EventType::Allocate, id);
+}
+
+void KoPoolTrace::Recorder::RecordDeallocate(const USize id) noexcept {
+    Record(EventType::Deallocate, id);
+}
+
+void KoPoolTrace::Recorder::RecordIterateBegin() noexcept {
+    Record(EventType::IterateBegin, 0);
+}
+
+void KoPoolTrace::Recorder::RecordIterateEnd() noexcept {
+    Record(EventType::IterateEnd, 0);
+}
+
+bool KoPoolTrace::Recorder::Flush() noexcept {
+
+    if (!_pFile) {
+        return false;
+    }
+
+    const bool isOk = _buffer.empty() || fwrite(_buffer.data(), 1, _buffer.size(), _pFile) == _buffer.size();
+    _buffer.clear();
+
+    return isOk && fflush(_pFile) == 0;
+}
+
+void KoPoolTrace::Recorder::Record(const EventType type, const USize id) noexcept {
+
+    if (!_pFile) {
+        return;
+    }
+
+    const uint64_t timestampNs = NowNs() - _startNs;
+
+    _buffer.push_back(static_cast<uint8_t>(type));
+    WriteVarUInt(_buffer, timestampNs - _prevTimestampNs);
+
+    if (type == EventType::Allocate || type == EventType::Deallocate) {
+        WriteVarUInt(_buffer, id);
+    }
+
+    _prevTimestampNs = timestampNs;
+
+    if (_buffer.size() >= BUFFER_SIZE_IN_BYTES) {
+
+        if (fwrite(_buffer.data(), 1, _buffer.size(), _pFile) != _buffer.size()) {
+
+            fclose(_pFile);
+            _pFile = nullptr;
+        }
+
+        _buffer.clear();
+    }
+}
+
+KoPoolTrace::Reader::Reader(const char* pPath) noexcept
+    : _pFile(fopen(pPath, "rb"))
+{
+    if (!_pFile) {
+        return;
+    }
+
+    if (fread(&_header, sizeof(_header), 1, _pFile) != 1 || _header.magic != MAGIC || _header.version != VERSION) {
+
+        fclose(_pFile);
+        _pFile = nullptr;
+    }
+}
+
+KoPoolTrace::Reader::~Reader() noexcept {
+
+    if (_pFile) {
+        fclose(_pFile);
+    }
+}
+
+bool KoPoolTrace::Reader::IsOpen() const noexcept {
+    return _pFile;
+}
+
+const KoPoolTrace::Header& KoPoolTrace::Reader::GetHeader() const noexcept {
+    return _header;
+}
+
+bool KoPoolTrace::Reader::Next(Event& event) noexcept {
+
+    if (!_pFile) {
+        return false;
+    }
+
+    const int type = fgetc(_pFile);
+
+    if (type == EOF) {
+
+        _isCorrupted = ferror(_pFile) != 0;
+        return false;
+    }
+
+    if (type >= static_cast<int>(EventType::COUNT)) {
+
+        _isCorrupted = true;
+        return false;
+    }
+
+    uint64_t deltaNs = 0;
+    if (!ReadVarUInt(deltaNs)) {
+
+        _isCorrupted = true;
+        return false;
+    }
+
+    _timestampNs += deltaNs;
+
+    event.type = static_cast<EventType>(type);
+    event.timestampNs = _timestampNs;
+    event.id = 0;
+
+    if (event.type == EventType::Allocate || event.type == EventType::Deallocate) {
+
+        uint64_t id = 0;
+        if (!ReadVarUInt(id) || id > std::numeric_limits<USize>::max()) {
+
+            _isCorrupted = true;
+            return false;
+        }
+
+        event.id = static_cast<USize>(id);
+    }
+
+    return true;
+}
+
+bool KoPoolTrace::Reader::IsCorrupted() const noexcept {
+    return _isCorrupted;
+}
+
+bool KoPoolTrace::Reader::ReadVarUInt(uint64_t& value) noexcept {
+
+    value = 0;
+
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+
+        const int byte = fgetc(_pFile);
+        if (byte == EOF) {
+            return false;
+        }
+
+        // The 10th byte has only the top bit of the value
+        if (shift == 63 && (byte & 0x7E) != 0) {
+            return false;
+        }
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+KoPoolTrace::ReplayResult KoPoolTrace::Replay(const char* pPath, KoPoolIteratable::Opt opt) noexcept {
+
+    ReplayResult result{};
+
+    Reader reader{ pPath };
+    if (!reader.IsOpen()) {
+        return result;
+    }
+
+    const Header& header = reader.GetHeader();
+
+    if (opt.elementSizeInBytes == 0) {
+        opt.elementSizeInBytes = static_cast<USize>(header.elementSizeInBytes);
+    }
+
+    if (opt.elementAlignment == 0) {
+        opt.elementAlignment = static_cast<USize>(header.elementAlignment);
+    }
+
+    if (opt.elementSizeInBytes < header.elementSizeInBytes || opt.elementAlignment < header.elementAlignment) {
+        return result;
+    }
+
+    KoPoolIteratable pool{ opt };
+
+    // Recorded ID -> replayed element, IDs are dense, so a vector is enough
+    std::vector<void*> pointers;
+
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    // 'false' if the trace doesn't match the replayed pool
+    const auto replayEvent = [&](const Event& event) -> bool {
+
+        result.numEvents += 1;
+        result.tracedSeconds = static_cast<double>(event.timestampNs) * 1e-9;
+
+        switch (event.type) {
+        case EventType::Allocate: {
+
+            // Also bounds 'pointers' by the size of the trace
+            if (event.id > result.numAllocations) {
+                return false;
+            }
+
+            const Clock::time_point start = Clock::now();
+            void* pMemory = pool.AllocateBytes().pMemory;
+            result.allocateSeconds += Seconds(Clock::now() - start).count();
+
+            if (!pMemory) {
+                return false;
+            }
+
+            // Touch like a constructor would
+            *reinterpret_cast<uint8_t*>(pMemory) = 1;
+
+            if (event.id >= pointers.size()) {
+                pointers.resize(static_cast<size_t>(event.id) + 1, nullptr);
+            }
+
+            if (pointers[event.id]) {
+
+                pool.DeallocateBytesByPtr(pMemory);
+                return false;
+            }
+
+            pointers[event.id] = pMemory;
+            result.numAllocations += 1;
+
+            result.peakSize = std::max(result.peakSize, pool.Size());
+            result.peakBytesReserved = std::max(result.peakBytesReserved, pool.BytesReserved());
+
+            return true;
+        }
+
+        case EventType::Deallocate: {
+
+            if (event.id >= pointers.size() || !pointers[event.id]) {
+                return false;
+            }
+
+            const Clock::time_point start = Clock::now();
+            pool.DeallocateBytesByPtr(pointers[event.id]);
+            result.deallocateSeconds += Seconds(Clock::now() - start).count();
+
+            pointers[event.id] = nullptr;
+            result.numDeallocations += 1;
+
+            return true;
+        }
+
+        case EventType::IterateBegin: {
+
+            const Clock::time_point start = Clock::now();
+
+            // The iterator needs the sub pools, a trace can iterate before the first allocation
+            size_t sum = 0;
+            if (!pool.IsEmpty()) {
+
+                KoPoolIterator<void> iterator = pool.GetIterator<void>();
+                while (const void* pMemory = iterator.Next()) {
+                    sum += *reinterpret_cast<const uint8_t*>(pMemory);
+                }
+            }
+
+            result.iterateSeconds += Seconds(Clock::now() - start).count();
+            result.numIterations += 1;
+
+            return sum == pool.Size();
+        }
+
+        case EventType::IterateEnd:
+            return true;
+
+        default:
+            __KO_POOL_UNREACHABLE__();
+        }
+    };
+
+    result.isOk = true;
+
+    Event event{};
+    while (result.isOk && reader.Next(event)) {
+        result.isOk = replayEvent(event);
+    }
+
+    // A corrupted event ends the loop like the end of the file
+    if (reader.IsCorrupted()) {
+        result.isOk = false;
+    }
+
+    // Elements of the trace which are never deallocated, an empty trace has no sub pools
+    if (!pool.IsEmpty()) {
+        pool.DeallocateBytesAll();
+    }
+
+    return result;
+}
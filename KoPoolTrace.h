@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "KoPoolIteratable.h"
+
+// Allocation traces of a live pool, so pools can be tuned offline against real traffic.
+// The file is a header followed by events: 1 byte of the event type, the LEB128 delta of the timestamp in nanoseconds
+// from the previous event and, for allocate/deallocate, the LEB128 ID of the element. IDs are the IDs of the recorded
+// pool (see 'KoPoolIteratable::PtrToID(...)'), they are remapped on replay, so the replayed pool can have any options
+class KoPoolTrace {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    static constexpr uint32_t MAGIC = 0x54504F4B; // "KOPT"
+    static constexpr uint32_t VERSION = 1;
+
+    enum class EventType : uint8_t {
+
+        Allocate,
+        Deallocate,
+        IterateBegin,
+        IterateEnd,
+
+        COUNT
+    };
+
+    struct Header {
+
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+
+        uint64_t elementSizeInBytes = 0;
+        uint64_t elementAlignment = 0;
+    };
+
+    struct Event {
+
+        EventType type = EventType::COUNT;
+        uint64_t timestampNs = 0;
+
+        // Valid for 'Allocate' and 'Deallocate'
+        USize id = 0;
+    };
+
+    // Wraps a live pool: calls are forwarded to the pool and recorded. Events are buffered and written
+    // by 'Flush()' or when the buffer is full. Not thread safe, like the pool
+    class Recorder {
+    public:
+
+        Recorder(KoPoolIteratable& pool, const char* pPath) noexcept;
+        ~Recorder() noexcept;
+
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+
+        bool IsOpen() const noexcept;
+
+        KoPoolIteratable::AllocBytesResult AllocateBytes() noexcept;
+
+        void DeallocateBytesByPtr(void* pMemory) noexcept;
+        void DeallocateBytesByPtrAndSubPoolID(void* pMemory, const USize subPoolID) noexcept;
+        void DeallocateBytesByID(const USize id) noexcept;
+
+        // For allocations which are done by the pool directly
+        void RecordAllocate(const USize id) noexcept;
+        void RecordDeallocate(const USize id) noexcept;
+
+        // Marks an iteration over the whole pool, the replay iterates the replayed pool between them
+        void RecordIterateBegin() noexcept;
+        void RecordIterateEnd() noexcept;
+
+        bool Flush() noexcept;
+
+    private:
+
+        void Record(const EventType type, const USize id) noexcept;
+
+    private:
+
+        static constexpr size_t BUFFER_SIZE_IN_BYTES = 64 * 1024;
+
+        KoPoolIteratable* _pPool = nullptr;
+        FILE* _pFile = nullptr;
+
+        std::vector<uint8_t> _buffer;
+
+        uint64_t _startNs = 0;
+        uint64_t _prevTimestampNs = 0;
+    };
+
+    class Reader {
+    public:
+
+        Reader(const char* pPath) noexcept;
+        ~Reader() noexcept;
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // 'false' if the file can't be opened or has a wrong header
+        bool IsOpen() const noexcept;
+        const Header& GetHeader() const noexcept;
+
+        // 'false' at the end of the file or on a corrupted event
+        bool Next(Event& event) noexcept;
+
+        // 'true' after 'Next(...)' stopped on an unknown event type, a truncated or overflowing number
+        // or a read error, rather than at the end of the file
+        bool IsCorrupted() const noexcept;
+
+    private:
+
+        bool ReadVarUInt(uint64_t& value) noexcept;
+
+    private:
+
+        FILE* _pFile = nullptr;
+        Header _header{};
+
+        uint64_t _timestampNs = 0;
+
+        bool _isCorrupted = false;
+    };
+
+    struct ReplayResult {
+
+        bool isOk = false;
+
+        uint64_t numEvents = 0;
+        uint64_t numAllocations = 0;
+        uint64_t numDeallocations = 0;
+        uint64_t numIterations = 0;
+
+        double allocateSeconds = 0.0;
+        double deallocateSeconds = 0.0;
+        double iterateSeconds = 0.0;
+
+        // Duration of the recorded trace
+        double tracedSeconds = 0.0;
+
+        USize peakSize = 0;
+        USize peakBytesReserved = 0;
+    };
+
+    // Reproduces the exact sequence of the trace against a pool with 'opt', events are replayed back to back.
+    // 'opt' element size/alignment must be >= the recorded ones, zero means the recorded one.
+    // The recorded pool must be empty when the recording starts: its IDs are then below the number of
+    // the allocations so far, and a larger ID fails the replay like a corrupted trace
+    static ReplayResult Replay(const char* pPath, KoPoolIteratable::Opt opt) noexcept;
+};
@@ -0,0 +1,242 @@
+#include "KoSlabAllocator.h"
+#include "KoPoolMemoryUtils.h"
+
+namespace {
+
+    using KoPoolMemoryUtils::AlignedMalloc;
+    using KoPoolMemoryUtils::AlignedFree;
+    using KoPoolMemoryUtils::RoundUp;
+}
+
+KoSlabAllocator::PageMap::~PageMap() noexcept {
+
+    for (Mid* pMid : _root) {
+
+        if (!pMid) {
+            continue;
+        }
+
+        for (Leaf* pLeaf : *pMid) {
+            delete pLeaf;
+        }
+
+        delete pMid;
+    }
+}
+
+bool KoSlabAllocator::PageMap::Set(const void* pMemory, const USize sizeInBytes, const PageInfo& info) noexcept {
+
+    const uintptr_t pageBegin = reinterpret_cast<uintptr_t>(pMemory) / PAGE_SIZE_IN_BYTES;
+    const uintptr_t pageEnd = pageBegin + sizeInBytes / PAGE_SIZE_IN_BYTES;
+
+    __KO_POOL_ITERATABLE_ASSERT_TEST__(sizeInBytes % PAGE_SIZE_IN_BYTES == 0);
+
+    for (uintptr_t page = pageBegin; page < pageEnd; ++page) {
+
+        const uintptr_t rootID = page >> (LEAF_BITS + MID_BITS);
+        const uintptr_t midID = (page >> LEAF_BITS) & ((static_cast<uintptr_t>(1) << MID_BITS) - 1);
+        const uintptr_t leafID = page & ((static_cast<uintptr_t>(1) << LEAF_BITS) - 1);
+
+        // Address is outside of the supported address space, the caller releases the memory
+        if (rootID >= _root.size()) {
+            return false;
+        }
+
+        Mid*& pMid = _root[rootID];
+        if (!pMid) {
+
+            pMid = new (std::nothrow) Mid{};
+            if (!pMid) {
+                return false;
+            }
+        }
+
+        Leaf*& pLeaf = (*pMid)[midID];
+        if (!pLeaf) {
+
+            pLeaf = new (std::nothrow) Leaf{};
+            if (!pLeaf) {
+                return false;
+            }
+        }
+
+        (*pLeaf)[leafID] = info;
+    }
+
+    return true;
+}
+
+KoSlabAllocator::PageInfo KoSlabAllocator::PageMap::Get(const void* pMemory) const noexcept {
+
+    const uintptr_t page = reinterpret_cast<uintptr_t>(pMemory) / PAGE_SIZE_IN_BYTES;
+
+    const uintptr_t rootID = page >> (LEAF_BITS + MID_BITS);
+    const uintptr_t midID = (page >> LEAF_BITS) & ((static_cast<uintptr_t>(1) << MID_BITS) - 1);
+    const uintptr_t leafID = page & ((static_cast<uintptr_t>(1) << LEAF_BITS) - 1);
+
+    if (rootID >= _root.size() || !_root[rootID]) {
+        return PageInfo{};
+    }
+
+    const Leaf* pLeaf = (*_root[rootID])[midID];
+    if (!pLeaf) {
+        return PageInfo{};
+    }
+
+    return (*pLeaf)[leafID];
+}
+
+KoSlabAllocator::KoSlabAllocator()
+    : KoSlabAllocator(Opt{})
+{}
+
+KoSlabAllocator::KoSlabAllocator(const Opt& opt)
+    : _opt(opt)
+{
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.sizeClassesCnt > 0 && opt.sizeClassesCnt <= SIZE_CLASSES_CNT_MAX);
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(opt.alignment != 0 && (opt.alignment & (opt.alignment - 1)) == 0);
+
+    for (USize i = 0; i < _opt.sizeClassesCnt; ++i) {
+
+        _opt.sizeClasses[i] = RoundUp(
+            std::max(_opt.sizeClasses[i], KoPoolIteratable::MIN_ELEMENT_SIZE_IN_BYTES), _opt.alignment
+        );
+
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(i == 0 || _opt.sizeClasses[i - 1] < _opt.sizeClasses[i]);
+    }
+
+    const USize maxSize = _opt.sizeClasses[_opt.sizeClassesCnt - 1];
+    _sizeToSizeClassID.resize(maxSize / _opt.alignment + 1);
+
+    USize sizeClassID = 0;
+    for (USize i = 0; i < static_cast<USize>(_sizeToSizeClassID.size()); ++i) {
+
+        if (i * _opt.alignment > _opt.sizeClasses[sizeClassID]) {
+            sizeClassID += 1;
+        }
+
+        _sizeToSizeClassID[i] = static_cast<uint8_t>(sizeClassID);
+    }
+
+    for (USize i = 0; i < _opt.sizeClassesCnt; ++i) {
+
+        _sizeClasses[i].pAllocator = this;
+        _sizeClasses[i].sizeClassID = i;
+
+        KoPoolIteratable::Opt poolOpt{};
+        poolOpt.elementSizeInBytes = _opt.sizeClasses[i];
+        poolOpt.elementAlignment = _opt.alignment;
+
+        poolOpt.subPoolAllocator.pAllocate = &KoSlabAllocator::AllocateSubPoolMemory;
+        poolOpt.subPoolAllocator.pDeallocate = &KoSlabAllocator::DeallocateSubPoolMemory;
+        poolOpt.subPoolAllocator.pUserData = &_sizeClasses[i];
+
+        _pools[i] = KoPoolIteratable{ poolOpt };
+    }
+}
+
+KoSlabAllocator::~KoSlabAllocator() noexcept {
+
+    // Release sub pools while the page map is alive
+    for (KoPoolIteratable& pool : _pools) {
+        pool = KoPoolIteratable{};
+    }
+}
+
+void* KoSlabAllocator::Allocate(const USize sizeInBytes) noexcept {
+
+    const USize sizeClassID = FindSizeClassID(sizeInBytes);
+    if (sizeClassID == SIZE_CLASS_ID_NONE) {
+        return nullptr;
+    }
+
+    return _pools[sizeClassID].AllocateBytes().pMemory;
+}
+
+void KoSlabAllocator::Deallocate(void* pMemory) noexcept {
+
+    if (!pMemory) {
+        return;
+    }
+
+    const PageInfo info = _pageMap.Get(pMemory);
+
+    // Allocated outside of the allocator, ignored in the release builds rather than indexing '_pools' by -1
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(info.sizeClassIDPlusOne != 0);
+    if (info.sizeClassIDPlusOne == 0) {
+        return;
+    }
+
+    _pools[info.sizeClassIDPlusOne - 1].DeallocateBytesByPtrAndSubPoolID(pMemory, info.subPoolID);
+}
+
+KoSlabAllocator::USize KoSlabAllocator::FindSizeClassID(const USize sizeInBytes) const noexcept {
+
+    const USize idx = sizeInBytes / _opt.alignment + (sizeInBytes % _opt.alignment != 0 ? 1 : 0);
+    if (idx >= static_cast<USize>(_sizeToSizeClassID.size())) {
+        return SIZE_CLASS_ID_NONE;
+    }
+
+    return _sizeToSizeClassID[idx];
+}
+
+KoSlabAllocator::USize KoSlabAllocator::FindSizeClassIDByPtr(const void* pMemory) const noexcept {
+
+    const PageInfo info = _pageMap.Get(pMemory);
+    return info.sizeClassIDPlusOne != 0 ? info.sizeClassIDPlusOne - 1 : SIZE_CLASS_ID_NONE;
+}
+
+KoSlabAllocator::USize KoSlabAllocator::GetSizeClassesCnt() const noexcept {
+    return _opt.sizeClassesCnt;
+}
+
+KoSlabAllocator::USize KoSlabAllocator::GetSizeClassSize(const USize sizeClassID) const noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(sizeClassID < _opt.sizeClassesCnt);
+    return _opt.sizeClasses[sizeClassID];
+}
+
+const KoPoolIteratable& KoSlabAllocator::GetPool(const USize sizeClassID) const noexcept {
+
+    __KO_POOL_ITERATABLE_ASSERT_DEV__(sizeClassID < _opt.sizeClassesCnt);
+    return _pools[sizeClassID];
+}
+
+void* KoSlabAllocator::AllocateSubPoolMemory(
+    void* pUserData, USize sizeInBytes, USize alignment, USize subPoolID
+) noexcept {
+
+    const SizeClass& sizeClass = *reinterpret_cast<const SizeClass*>(pUserData);
+
+    // Page aligned and page sized, so a page belongs only to one sub pool
+    const USize sizeInBytesAligned = RoundUp(sizeInBytes, PAGE_SIZE_IN_BYTES);
+    void* pMemory = AlignedMalloc(sizeInBytesAligned, std::max(alignment, PAGE_SIZE_IN_BYTES));
+
+    if (!pMemory) {
+        return nullptr;
+    }
+
+    PageInfo info{};
+    info.sizeClassIDPlusOne = static_cast<uint16_t>(sizeClass.sizeClassID + 1);
+    info.subPoolID = static_cast<uint16_t>(subPoolID);
+
+    if (!sizeClass.pAllocator->_pageMap.Set(pMemory, sizeInBytesAligned, info)) {
+
+        sizeClass.pAllocator->_pageMap.Set(pMemory, sizeInBytesAligned, PageInfo{});
+        AlignedFree(pMemory);
+
+        return nullptr;
+    }
+
+    return pMemory;
+}
+
+void KoSlabAllocator::DeallocateSubPoolMemory(
+    void* pUserData, void* pMemory, USize sizeInBytes, USize /*alignment*/, USize /*subPoolID*/
+) noexcept {
+
+    const SizeClass& sizeClass = *reinterpret_cast<const SizeClass*>(pUserData);
+
+    sizeClass.pAllocator->_pageMap.Set(pMemory, RoundUp(sizeInBytes, PAGE_SIZE_IN_BYTES), PageInfo{});
+    AlignedFree(pMemory);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+#include "KoPoolIteratable.h"
+
+// Owns a 'KoPoolIteratable' per size class and routes 'Allocate(size)' to the pool of the rounded size class.
+// Sub pool memory is page aligned and registered in a page map, so 'Deallocate(ptr)' finds the size class
+// and the sub pool without binary searching the sub pools of each pool. The sub pools are rounded up to the page size,
+// so the first (tiny) sub pools of each size class take a page. Not thread safe
+class KoSlabAllocator {
+public:
+
+    using USize = KoPoolIteratable::USize;
+
+    static constexpr USize SIZE_CLASSES_CNT_MAX = 32;
+    static constexpr USize SIZE_CLASS_ID_NONE = SIZE_CLASSES_CNT_MAX;
+
+    static constexpr USize PAGE_SIZE_IN_BYTES = 4096;
+
+    struct Opt {
+
+        // Sorted, each size is rounded up to 'alignment' and must be >= 'KoPoolIteratable::MIN_ELEMENT_SIZE_IN_BYTES'
+        std::array<USize, SIZE_CLASSES_CNT_MAX> sizeClasses{ 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+        USize sizeClassesCnt = 12;
+
+        USize alignment = alignof(std::max_align_t);
+    };
+
+    KoSlabAllocator();
+    KoSlabAllocator(const Opt& opt);
+    ~KoSlabAllocator() noexcept;
+
+    // Pools store pointers to the allocator
+    KoSlabAllocator(const KoSlabAllocator&) = delete;
+    KoSlabAllocator& operator=(const KoSlabAllocator&) = delete;
+
+    // Returns 'nullptr' if 'sizeInBytes' is greater than the largest size class
+    void* Allocate(const USize sizeInBytes) noexcept;
+
+    // A pointer outside of the pages of the allocator is a DEV assert and is ignored otherwise
+    void Deallocate(void* pMemory) noexcept;
+
+    template <typename T, typename ...Args>
+    T* Allocate(Args&&... args) noexcept(std::is_nothrow_constructible_v<T>) {
+
+        static_assert(alignof(T) <= alignof(std::max_align_t), "");
+        __KO_POOL_ITERATABLE_ASSERT_DEV__(alignof(T) <= _opt.alignment);
+
+        T* pData = reinterpret_cast<T*>(Allocate(sizeof(T)));
+        if (!pData) {
+            return nullptr;
+        }
+
+        new (pData) T{ std::forward<Args>(args)... };
+
+        return pData;
+    }
+
+    template <typename T>
+    void Deallocate(T* pMemory) noexcept(std::is_nothrow_destructible_v<T>) {
+
+        if (!pMemory) {
+            return;
+        }
+
+        pMemory->~T();
+
+        Deallocate(static_cast<void*>(pMemory));
+    }
+
+    USize FindSizeClassID(const USize sizeInBytes) const noexcept;
+    USize FindSizeClassIDByPtr(const void* pMemory) const noexcept;
+
+    USize GetSizeClassesCnt() const noexcept;
+    USize GetSizeClassSize(const USize sizeClassID) const noexcept;
+
+    // Elements of a size class can be iterated untyped by 'KoPoolIterator<void>', see 'KoPoolIteratable::GetIterator()'
+    const KoPoolIteratable& GetPool(const USize sizeClassID) const noexcept;
+
+    template <typename T>
+    KoPoolIterator<T> GetIterator(const USize sizeClassID) const noexcept {
+        return GetPool(sizeClassID).GetIterator<T>();
+    }
+
+private:
+
+    struct PageInfo {
+
+        // 0 - the page is not allocated by the allocator, otherwise 'sizeClassID + 1'
+        uint16_t sizeClassIDPlusOne = 0;
+        uint16_t subPoolID = 0;
+    };
+
+    // Radix tree of pages: 'ROOT_BITS' + 'MID_BITS' + 'LEAF_BITS' + log2('PAGE_SIZE_IN_BYTES') address bits
+    class PageMap {
+    public:
+
+        static constexpr USize LEAF_BITS = 12;
+        static constexpr USize MID_BITS = 12;
+        static constexpr USize ROOT_BITS = 12;
+
+        PageMap() noexcept = default;
+        ~PageMap() noexcept;
+
+        PageMap(const PageMap&) = delete;
+        PageMap& operator=(const PageMap&) = delete;
+
+        // False when out of memory or the address is outside of the 48 bit address space
+        bool Set(const void* pMemory, const USize sizeInBytes, const PageInfo& info) noexcept;
+        PageInfo Get(const void* pMemory) const noexcept;
+
+    private:
+
+        using Leaf = std::array<PageInfo, static_cast<USize>(1) << LEAF_BITS>;
+        using Mid = std::array<Leaf*, static_cast<USize>(1) << MID_BITS>;
+
+        std::array<Mid*, static_cast<USize>(1) << ROOT_BITS> _root{ nullptr };
+    };
+
+    struct SizeClass {
+
+        KoSlabAllocator* pAllocator = nullptr;
+        USize sizeClassID = SIZE_CLASS_ID_NONE;
+    };
+
+    static void* AllocateSubPoolMemory(
+        void* pUserData, USize sizeInBytes, USize alignment, USize subPoolID
+    ) noexcept;
+
+    static void DeallocateSubPoolMemory(
+        void* pUserData, void* pMemory, USize sizeInBytes, USize alignment, USize subPoolID
+    ) noexcept;
+
+private:
+
+    Opt _opt;
+
+    // 'sizeInBytes' / 'opt.alignment' -> size class ID
+    std::vector<uint8_t> _sizeToSizeClassID;
+
+    // Must be destroyed after the pools
+    PageMap _pageMap;
+
+    std::array<SizeClass, SIZE_CLASSES_CNT_MAX> _sizeClasses{};
+    std::array<KoPoolIteratable, SIZE_CLASSES_CNT_MAX> _pools{};
+};
@@ -1,11 +1,19 @@
 #include <vector>
 #include <string>
 #include <random>
-#include <chrono>
 #include <iostream>
+#include <list>
+#include <filesystem>
 
 #include "unordered_dense.h"
 #include "KoPoolIteratable.h"
+#include "KoPoolMemoryResource.h"
+#include "KoSlabAllocator.h"
+#include "KoPoolTrace.h"
+#include "KoPoolReclaimer.h"
+#include "KoPoolBlockCache.h"
+#include "KoPoolPtr.h"
+#include "KoPoolRankIndex.h"
 
 #define DevAssert(expression, message) \
 do { \
@@ -45,10 +53,70 @@ public:
             DevAssert(_datas.empty(), "");
             DevAssert(_set.empty(), "");
 
-            printf("TestAndBench_Allocate_Deallocate_Iterate:\n");
-            TestAndBench_Allocate_Deallocate_Iterate();
+            printf("Test_Allocate_Deallocate_Iterate:\n");
+            Test_Allocate_Deallocate_Iterate();
             DevAssert(_datas.empty(), "");
             DevAssert(_set.empty(), "");
+
+            printf("Test_MemoryResource:\n");
+            Test_MemoryResource();
+
+            printf("Test_SlabAllocator:\n");
+            Test_SlabAllocator();
+
+            printf("Test_Columns:\n");
+            Test_Columns();
+
+            printf("Test_Trace:\n");
+            Test_Trace();
+
+            printf("Test_MaxSubPoolSize:\n");
+            Test_MaxSubPoolSize();
+
+            printf("Test_Reclaimer:\n");
+            Test_Reclaimer();
+
+            printf("Test_Trim:\n");
+            Test_Trim();
+
+            printf("Test_BlockCache:\n");
+            Test_BlockCache();
+
+            printf("Test_InitialSubPoolSize:\n");
+            Test_InitialSubPoolSize();
+
+            printf("Test_ColocatedSkipBitmap:\n");
+            Test_ColocatedSkipBitmap();
+
+            printf("Test_MinElementSize:\n");
+            Test_MinElementSize();
+
+            printf("Test_FindSubPoolIDByPtr:\n");
+            Test_FindSubPoolIDByPtr();
+
+            printf("Test_NextEx:\n");
+            Test_NextEx();
+
+            printf("Test_UniquePtr:\n");
+            Test_UniquePtr();
+
+            printf("Test_RefPtr:\n");
+            Test_RefPtr();
+
+            printf("Test_DeallocateLater:\n");
+            Test_DeallocateLater();
+
+            printf("Test_DeallocateRange:\n");
+            Test_DeallocateRange();
+
+            printf("Test_Clear:\n");
+            Test_Clear();
+
+            printf("Test_ElementDestructor:\n");
+            Test_ElementDestructor();
+
+            printf("Test_RankIndex:\n");
+            Test_RankIndex();
         }
     }
 
@@ -143,46 +211,33 @@ private:
         }
     }
 
-    void TestAndBench_Allocate_Deallocate_Iterate() {
-
-        Bench bench{};
+    void Test_Allocate_Deallocate_Iterate() {
 
         size_t id = 0;
         for (size_t i = 0; i < SIZE; ++i) {
 
-            Data* pData = nullptr;
-
-            KoPoolIteratable::AllocBytesResult alloc{};
-            bench.TimeScope(Bench::KoPoolAllocate, [&]() {
-
-                alloc = _pPool->AllocateBytes();
-                pData = reinterpret_cast<Data*>(alloc.pMemory);
-            });
+            const KoPoolIteratable::AllocBytesResult alloc = _pPool->AllocateBytes();
+            Data* pData = reinterpret_cast<Data*>(alloc.pMemory);
 
             DevAssert(id == _pPool->PtrToID(alloc.pMemory, alloc.subPoolID), "");
+            DevAssert(id == alloc.id, "");
             DevAssert(_pPool->IDToPtr(id) == alloc.pMemory, "");
             DevAssert(_pPool->IDToSubPoolID(id) == alloc.subPoolID, "");
             id += 1;
 
-            // Don't bench constructor call
             new (pData) Data{};
+            _datas.push_back(pData);
 
-            bench.TimeScope(Bench::STDVectorPush, [&]() {
-                _datas.push_back(pData);
-            });
-
-            bool isInserted = false;
-            bench.TimeScope(Bench::UnorderedSetInsert, [&]() {
-                isInserted = _set.insert(pData).second;
-            });
-
+            const bool isInserted = _set.insert(pData).second;
             DevAssert(isInserted, "");
         }
 
-        std::shuffle(_datas.begin(), _datas.end(), _rng);
+        DevAssert(_pPool->Size() == _datas.size(), "");
+        DevAssert(_pPool->Capacity() >= _datas.size(), "");
 
-        bench.TimeScope(Bench::KoPoolIterate, [&]() {
+        std::shuffle(_datas.begin(), _datas.end(), _rng);
 
+        {
             size_t cnt = 0;
             KoPoolIterator<Data> iterator = _pPool->GetIterator<Data>();
             while (const Data* pData = iterator.Next()) {
@@ -190,32 +245,29 @@ private:
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
-
-        bench.TimeScope(Bench::STDVectorIterate, [&]() {
+        }
 
+        {
             size_t cnt = 0;
             for (const Data* pData : _datas) {
                 cnt += pData->cnt;
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
-
-        bench.TimeScope(Bench::UnorderedSetIterate, [&]() {
+        }
 
+        {
             size_t cnt = 0;
             for (const Data* pData : _set) {
                 cnt += pData->cnt;
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
+        }
 
         const size_t numToRemove = _distribution(_rng);
         for (size_t i = 0; i < numToRemove; ++i) {
 
-            // Don't bench destructor call
             _datas.back()->~Data();
 
             const KoPoolIteratable::USize subPoolID = _pPool->FindSubPoolIDByPtr(_datas.back());
@@ -223,24 +275,47 @@ private:
             DevAssert(reinterpret_cast<uint8_t*>(_datas.back()) == _pPool->IDToPtr(id), "");
             DevAssert(subPoolID == _pPool->IDToSubPoolID(id), "");
 
-            bench.TimeScope(Bench::KoPoolDeallocate, [&]() {
+            //_pPool->DeallocateBytesByID(id);
+            //_pPool->DeallocateBytesByPtrAndSubPoolID(_datas.back(), subPoolID);
+            _pPool->DeallocateBytesByPtr(_datas.back());
 
-                //_pPool->DeallocateBytesByID(id);
-                //_pPool->DeallocateBytesByPtrAndSubPoolID(_datas.back(), subPoolID);
-                _pPool->DeallocateBytesByPtr(_datas.back());
-            });
+            _set.erase(_datas.back());
+            _datas.pop_back();
+        }
 
-            bench.TimeScope(Bench::UnorderedSetErase, [&]() {
-                _set.erase(_datas.back());
-            });
+        DevAssert(_pPool->Size() == _datas.size(), "");
 
-            bench.TimeScope(Bench::STDVectorPop, [&]() {
-                _datas.pop_back();
-            });
+        {
+            const KoPoolIteratable::Stats stats = _pPool->GetStats();
+            DevAssert(stats.numUsed == _datas.size(), "");
+            DevAssert(stats.numSlots == _pPool->Capacity(), "");
+
+            printf(
+                "Stats: %zu slots, %zu used, %zu free runs, %zu data bytes, %zu bitmap bytes\n",
+                static_cast<size_t>(stats.numSlots), static_cast<size_t>(stats.numUsed), static_cast<size_t>(stats.numFreeRuns),
+                static_cast<size_t>(stats.dataSizeInBytes), static_cast<size_t>(stats.skipBitmapSizeInBytes)
+            );
         }
 
-        bench.TimeScope(Bench::KoPoolIterate, [&]() {
+#ifdef __KO_POOL_ITERATABLE_INSTRUMENTATION__
+        for (size_t i = 0; i < KoPoolInstrumentation::Event::COUNT; ++i) {
+
+            const KoPoolInstrumentation::Event event = static_cast<KoPoolInstrumentation::Event>(i);
+            const KoPoolInstrumentation::Histogram& histogram = _pPool->GetInstrumentation().GetHistogram(event);
+
+            printf(
+                "%s: %llu calls, %llu ticks total, p50 <= %llu, p99 <= %llu, max %llu\n",
+                KoPoolInstrumentation::EVENT_TO_STR[event],
+                static_cast<unsigned long long>(histogram.cnt),
+                static_cast<unsigned long long>(histogram.totalTicks),
+                static_cast<unsigned long long>(histogram.GetPercentileTicks(0.5)),
+                static_cast<unsigned long long>(histogram.GetPercentileTicks(0.99)),
+                static_cast<unsigned long long>(histogram.maxTicks)
+            );
+        }
+#endif
 
+        {
             size_t cnt = 0;
             KoPoolIterator<Data> iterator = _pPool->GetIterator<Data>();
             while (const Data* pData = iterator.Next()) {
@@ -248,55 +323,37 @@ private:
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
-
-        bench.TimeScope(Bench::STDVectorIterate, [&]() {
+        }
 
+        {
             size_t cnt = 0;
             for (const Data* pData : _datas) {
                 cnt += pData->cnt;
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
-
-        bench.TimeScope(Bench::UnorderedSetIterate, [&]() {
+        }
 
+        {
             size_t cnt = 0;
             for (const Data* pData : _set) {
                 cnt += pData->cnt;
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
+        }
 
         for (size_t i = 0; i < SIZE; ++i) {
 
-            Data* pData = nullptr;
-
-            bench.TimeScope(Bench::KoPoolAllocate, [&]() {
-
-                KoPoolIteratable::AllocBytesResult alloc = _pPool->AllocateBytes();
-                pData = reinterpret_cast<Data*>(alloc.pMemory);
-            });
-
-            // Don't bench constructor call
+            Data* pData = reinterpret_cast<Data*>(_pPool->AllocateBytes().pMemory);
             new (pData) Data{};
+            _datas.push_back(pData);
 
-            bench.TimeScope(Bench::STDVectorPush, [&]() {
-                _datas.push_back(pData);
-            });
-
-            bool isInserted = false;
-            bench.TimeScope(Bench::UnorderedSetInsert, [&]() {
-                isInserted = _set.insert(pData).second;
-            });
-
+            const bool isInserted = _set.insert(pData).second;
             DevAssert(isInserted, "");
         }
 
-        bench.TimeScope(Bench::KoPoolIterate, [&]() {
-
+        {
             size_t cnt = 0;
             KoPoolIterator<Data> iterator = _pPool->GetIterator<Data>();
             while (const Data* pData = iterator.Next()) {
@@ -304,27 +361,25 @@ private:
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
-
-        bench.TimeScope(Bench::STDVectorIterate, [&]() {
+        }
 
+        {
             size_t cnt = 0;
             for (const Data* pData : _datas) {
                 cnt += pData->cnt;
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
-
-        bench.TimeScope(Bench::UnorderedSetIterate, [&]() {
+        }
 
+        {
             size_t cnt = 0;
             for (const Data* pData : _set) {
                 cnt += pData->cnt;
             }
 
             DevAssert(cnt == _datas.size(), "");
-        });
+        }
 
         for (size_t i = 0; i < _datas.size(); ++i) {
 
@@ -343,93 +398,1282 @@ private:
 
             DevAssert(cnt == _datas.size(), "");
         }
+    }
+
+    void Test_MemoryResource() {
+
+        // Layout of the 'std::list' node in libstdc++ and MSVC STL
+        struct ListNode {
+
+            void* pNext;
+            void* pPrev;
+
+            Data data;
+        };
+
+        KoPoolMemoryResource::Opt opt{};
+        opt.nodeSizeInBytes = sizeof(ListNode);
+        opt.nodeAlignment = alignof(ListNode);
+
+        KoPoolMemoryResource koPoolResource{ opt };
+        std::pmr::unsynchronized_pool_resource pmrPoolResource{};
+
+        {
+            std::pmr::list<Data> koPoolList{ &koPoolResource };
+            std::pmr::list<Data> pmrPoolList{ &pmrPoolResource };
+
+            for (size_t i = 0; i < SIZE; ++i) {
+
+                koPoolList.emplace_back();
+                pmrPoolList.emplace_back();
+            }
+
+            DevAssert(!koPoolResource.GetPool().IsEmpty(), "");
+
+            // Erase a random half to scatter the vacant nodes
+            std::bernoulli_distribution isErase{ 0.5 };
+
+            std::pmr::list<Data>::iterator koPoolIt = koPoolList.begin();
+            std::pmr::list<Data>::iterator pmrPoolIt = pmrPoolList.begin();
+
+            while (koPoolIt != koPoolList.end()) {
+
+                if (isErase(_rng)) {
+
+                    koPoolIt = koPoolList.erase(koPoolIt);
+                    pmrPoolIt = pmrPoolList.erase(pmrPoolIt);
+                }
+                else {
+
+                    ++koPoolIt;
+                    ++pmrPoolIt;
+                }
+            }
+
+            DevAssert(koPoolList.size() == pmrPoolList.size(), "");
+
+            {
+                size_t cnt = 0;
+                for (const Data& data : koPoolList) {
+                    cnt += data.cnt;
+                }
+
+                DevAssert(cnt == koPoolList.size(), "");
+            }
+
+            {
+                size_t cnt = 0;
+                KoPoolIterator<ListNode> iterator = koPoolResource.GetPool().GetIterator<ListNode>();
+                while (const ListNode* pNode = iterator.Next()) {
+                    cnt += pNode->data.cnt;
+                }
+
+                DevAssert(cnt == koPoolList.size(), "");
+            }
+
+            {
+                size_t cnt = 0;
+                for (const Data& data : pmrPoolList) {
+                    cnt += data.cnt;
+                }
+
+                DevAssert(cnt == pmrPoolList.size(), "");
+            }
+        }
 
-        bench.Print();
+        DevAssert(koPoolResource.GetPool().IsEmpty(), "");
     }
 
-private:
+    void Test_SlabAllocator() {
+
+        KoSlabAllocator slab{};
+
+        std::uniform_int_distribution<size_t> sizeDistribution{ 1, slab.GetSizeClassSize(slab.GetSizeClassesCnt() - 1) };
+
+        std::vector<std::pair<uint8_t*, size_t>> allocations;
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            const size_t sizeInBytes = sizeDistribution(_rng);
+
+            uint8_t* pMemory = reinterpret_cast<uint8_t*>(slab.Allocate(sizeInBytes));
+            DevAssert(pMemory, "");
+
+            const KoSlabAllocator::USize sizeClassID = slab.FindSizeClassIDByPtr(pMemory);
+            DevAssert(sizeClassID == slab.FindSizeClassID(sizeInBytes), "");
+            DevAssert(slab.GetSizeClassSize(sizeClassID) >= sizeInBytes, "");
+
+            std::memset(pMemory, static_cast<int>(sizeClassID), sizeInBytes);
+            allocations.emplace_back(pMemory, sizeInBytes);
+        }
+
+        std::shuffle(allocations.begin(), allocations.end(), _rng);
 
-    class Bench {
-    public:
+        const size_t numToRemove = allocations.size() / 2;
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            slab.Deallocate(allocations.back().first);
+            allocations.pop_back();
+        }
+
+        size_t cnt = 0;
+        for (KoSlabAllocator::USize sizeClassID = 0; sizeClassID < slab.GetSizeClassesCnt(); ++sizeClassID) {
+
+            KoPoolIterator<void> iterator = slab.GetIterator<void>(sizeClassID);
+            while (const void* pMemory = iterator.Next()) {
+
+                DevAssert(*reinterpret_cast<const uint8_t*>(pMemory) == sizeClassID, "");
+                cnt += 1;
+            }
+        }
 
-        enum Section : size_t {
+        DevAssert(cnt == allocations.size(), "");
 
-            KoPoolAllocate,
-            KoPoolDeallocate,
-            KoPoolIterate,
+        for (const std::pair<uint8_t*, size_t>& allocation : allocations) {
+            slab.Deallocate(allocation.first);
+        }
+
+        printf("%zu\n", cnt);
+    }
 
-            STDVectorPush,
-            STDVectorPop,
-            STDVectorIterate,
+    void Test_Columns() {
 
-            UnorderedSetInsert,
-            UnorderedSetErase,
-            UnorderedSetIterate,
+        struct Element {
 
-            COUNT
+            size_t id = 0;
+            size_t cnt = 1;
         };
 
-        template <typename Func>
-        void TimeScope(const Section section, Func&& func) {
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Element);
+        opt.elementAlignment = alignof(Element);
+
+        opt.columnsCnt = 3;
+        opt.columnSizesInBytes[1] = sizeof(float);
+        opt.columnAlignments[1] = alignof(float);
+        opt.columnSizesInBytes[2] = sizeof(double);
+        opt.columnAlignments[2] = alignof(double);
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<Element*> elements;
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            Element* pElement = new (alloc.pMemory) Element{ i };
 
-            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            *pool.GetColumn<float>(pElement, alloc.subPoolID, 1) = static_cast<float>(i);
+            *pool.GetColumn<double>(pElement, alloc.subPoolID, 2) = static_cast<double>(i) * 2.0;
 
-            (func)();
+            DevAssert(
+                pool.IDToColumnPtr(pool.PtrToID(pElement, alloc.subPoolID), 2) ==
+                    reinterpret_cast<uint8_t*>(pool.GetColumn<double>(pElement, alloc.subPoolID, 2)),
+                ""
+            );
 
-            const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-            const std::chrono::duration<float> duration = end - start;
+            elements.push_back(pElement);
+        }
+
+        std::shuffle(elements.begin(), elements.end(), _rng);
+
+        const size_t numToRemove = _distribution(_rng);
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            pool.Deallocate(elements.back());
+            elements.pop_back();
+        }
+
+        {
+            size_t cnt = 0;
+
+            Element* pElement = nullptr;
+            float* pFloat = nullptr;
+            double* pDouble = nullptr;
+
+            KoPoolColumnsIterator<Element, float, double> iterator =
+                pool.GetColumnsIterator<Element, float, double>({ 0, 1, 2 });
+
+            while (iterator.Next(pElement, pFloat, pDouble)) {
+
+                DevAssert(*pFloat == static_cast<float>(pElement->id), "");
+                DevAssert(*pDouble == static_cast<double>(pElement->id) * 2.0, "");
+
+                cnt += pElement->cnt;
+            }
 
-            _timings[section].accum += duration.count();
-            _timings[section].cnt += 1;
+            DevAssert(cnt == elements.size(), "");
         }
 
-        void Print() {
+        {
+            size_t cnt = 0;
 
-            size_t maxSize = 0;
-            for (const std::string_view& str : SECTION_TO_STR) {
-                maxSize = std::max(str.size(), maxSize);
+            double* pDouble = nullptr;
+
+            KoPoolColumnsIterator<double> iterator = pool.GetColumnsIterator<double>({ 2 });
+            while (iterator.Next(pDouble)) {
+                cnt += 1;
             }
 
-            for (size_t i = 0; i < Section::COUNT; ++i) {
+            DevAssert(cnt == elements.size(), "");
+        }
+
+        for (Element* pElement : elements) {
+            pool.Deallocate(pElement);
+        }
+
+        printf("%zu\n", elements.size());
+    }
+
+    void Test_Trace() {
+
+        const std::string path = (std::filesystem::temp_directory_path() / "KoPoolTest.trace").string();
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+
+        KoPoolIteratable pool{ opt };
+
+        size_t numAllocations = 0;
+        size_t numDeallocations = 0;
+        KoPoolIteratable::USize peakSize = 0;
+
+        {
+            KoPoolTrace::Recorder recorder{ pool, path.c_str() };
+            DevAssert(recorder.IsOpen(), "");
+
+            std::vector<void*> pointers;
+            std::bernoulli_distribution isDeallocate{ 0.4 };
 
-                printf("%s: ", SECTION_TO_STR[i].data());
+            for (size_t i = 0; i < SIZE; ++i) {
+
+                if (!pointers.empty() && isDeallocate(_rng)) {
+
+                    std::swap(pointers[_rng() % pointers.size()], pointers.back());
+
+                    recorder.DeallocateBytesByPtr(pointers.back());
+                    pointers.pop_back();
+                    numDeallocations += 1;
+                }
+                else {
 
-                for (size_t j = 0; SECTION_TO_STR[i].size() + j < maxSize; ++j) {
-                    printf(" ");
+                    pointers.push_back(recorder.AllocateBytes().pMemory);
+                    numAllocations += 1;
                 }
 
-                printf("%fms\n", _timings[i].accum / (double)_timings[i].cnt * 1'000);
+                peakSize = std::max(peakSize, pool.Size());
+
+                if (i % (SIZE / 4) == 0) {
+
+                    recorder.RecordIterateBegin();
+                    recorder.RecordIterateEnd();
+                }
             }
 
-            printf("--------------------------\n");
+            DevAssert(recorder.Flush(), "");
         }
 
-    public:
+        pool.DeallocateBytesAll();
 
-        static constexpr std::array<std::string_view, Section::COUNT> SECTION_TO_STR{
+        // Replay with bigger elements than recorded, the sequence is the same
+        KoPoolIteratable::Opt replayOpt{};
+        replayOpt.elementSizeInBytes = sizeof(Data) * 2;
+        replayOpt.elementAlignment = alignof(Data);
 
-            "[KoPool] Allocate",
-            "[KoPool] Deallocate",
-            "[KoPool] Iterate",
+        const KoPoolTrace::ReplayResult result = KoPoolTrace::Replay(path.c_str(), replayOpt);
 
-            "[STDVector] Push",
-            "[STDVector] Pop",
-            "[STDVector] Iterate",
+        DevAssert(result.isOk, "");
+        DevAssert(result.numAllocations == numAllocations, "");
+        DevAssert(result.numDeallocations == numDeallocations, "");
+        DevAssert(result.numIterations == 4, "");
+        DevAssert(result.peakSize == peakSize, "");
 
-            "[UnorderedSet] Insert",
-            "[UnorderedSet] Erase",
-            "[UnorderedSet] Iterate",
-        };
+        std::filesystem::remove(path);
 
-        struct Time {
-            double accum = 0.0;
-            size_t cnt = 0;
-        };
+        printf("%zu\n", static_cast<size_t>(result.numEvents));
+    }
 
-    private:
+    void Test_MaxSubPoolSize() {
 
-        std::array<Time, Section::COUNT> _timings{};
-    };
+        // ~'SIZE' / 32, e.g. 2^15 for 1'000'000
+        size_t maxSubPoolSize = 2;
+        size_t maxSubPoolSizeLog2 = 1;
+        while (maxSubPoolSize < SIZE / 32) {
+            maxSubPoolSize *= 2;
+            maxSubPoolSizeLog2 += 1;
+        }
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.maxSubPoolSize = maxSubPoolSize;
+
+        KoPoolIteratable pool{ opt };
+
+        // At most 'maxSubPoolSizeLog2' + 1 sub pools grow up to the cap, the others are capped but the last one,
+        // e.g. 15 * 2^15 in the 32 sub pools of '__KO_POOL_ITERATABLE_USIZE__' = 'uint32_t'
+        const size_t numElements = std::min<size_t>(
+            SIZE, maxSubPoolSize * (KoPoolIteratable::SUBPOOLS_CNT - maxSubPoolSizeLog2 - 2)
+        );
+
+        std::vector<Data*> datas;
+        for (size_t i = 0; i < numElements; ++i) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            DevAssert(alloc.pMemory, "");
+            DevAssert(pool.GetSubPoolCapacity(alloc.subPoolID) <= maxSubPoolSize, "");
+
+            const KoPoolIteratable::USize id = pool.PtrToID(alloc.pMemory, alloc.subPoolID);
+            DevAssert(pool.IDToPtr(id) == alloc.pMemory, "");
+            DevAssert(pool.IDToSubPoolID(id) == alloc.subPoolID, "");
+
+            datas.push_back(new (alloc.pMemory) Data{});
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        const size_t numToRemove = std::min<size_t>(_distribution(_rng), datas.size());
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            pool.Deallocate(datas.back());
+            datas.pop_back();
+        }
+
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+            cnt += pData->cnt;
+        }
+
+        DevAssert(cnt == datas.size(), "");
+
+        for (Data* pData : datas) {
+            pool.Deallocate(pData);
+        }
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_Reclaimer() {
+
+        KoPoolReclaimer reclaimer{};
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.subPoolReclaimer = reclaimer.GetSubPoolReclaimer();
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<Data*> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+            datas.push_back(pool.Allocate<Data>());
+        }
+
+        const KoPoolIteratable::USize bytesReserved = pool.BytesReserved();
+
+        // Empties sub pools from the first one, all but the retained one are handed to the reclaimer
+        for (Data* pData : datas) {
+            pool.Deallocate(pData);
+        }
+
+        DevAssert(pool.IsEmpty(), "");
+        DevAssert(reclaimer.GetNumPending() > 0, "");
+        DevAssert(pool.BytesReserved() < bytesReserved, "");
+
+        const KoPoolIteratable::USize numBytesPending = reclaimer.GetNumBytesPending();
+        DevAssert(reclaimer.ReleasePending() == numBytesPending, "");
+        DevAssert(reclaimer.GetNumPending() == 0, "");
+
+        // The retained sub pool is handed to the reclaimer too, its bytes are counted there
+        DevAssert(pool.Trim() == 0, "");
+        DevAssert(reclaimer.GetNumPending() == 1, "");
+        DevAssert(reclaimer.ReleasePending() > 0, "");
+
+        // The queue is full after the first sub pool, the rest are freed synchronously
+        {
+            KoPoolReclaimer::Opt reclaimerOpt{};
+            reclaimerOpt.numPendingReserved = 1;
+
+            KoPoolReclaimer fullReclaimer{ reclaimerOpt };
+            opt.subPoolReclaimer = fullReclaimer.GetSubPoolReclaimer();
+
+            KoPoolIteratable fullPool{ opt };
+
+            datas.clear();
+            for (size_t i = 0; i < SIZE; ++i) {
+                datas.push_back(fullPool.Allocate<Data>());
+            }
+
+            for (Data* pData : datas) {
+                fullPool.Deallocate(pData);
+            }
+
+            DevAssert(fullReclaimer.GetNumPending() == 1, "");
+        }
+
+        // The background thread frees the rest when the reclaimer is destroyed
+        KoPoolReclaimer::Opt reclaimerOpt{};
+        reclaimerOpt.isBackgroundThread = true;
+        reclaimerOpt.period = std::chrono::milliseconds{ 1 };
+
+        KoPoolReclaimer backgroundReclaimer{ reclaimerOpt };
+        opt.subPoolReclaimer = backgroundReclaimer.GetSubPoolReclaimer();
+
+        KoPoolIteratable backgroundPool{ opt };
+
+        for (size_t iter = 0; iter < 4; ++iter) {
+
+            datas.clear();
+            for (size_t i = 0; i < SIZE / 4; ++i) {
+                datas.push_back(backgroundPool.Allocate<Data>());
+            }
+
+            for (Data* pData : datas) {
+                backgroundPool.Deallocate(pData);
+            }
+        }
+
+        DevAssert(backgroundPool.IsEmpty(), "");
+
+        printf("%zu\n", static_cast<size_t>(numBytesPending));
+    }
+
+    void Test_Trim() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.pageMappedSubPoolSizeInBytes = 64 * 1024;
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<Data*> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+            datas.push_back(pool.Allocate<Data>());
+        }
+
+        // A long free run in the largest sub pools, the elements are allocated in memory order
+        for (size_t i = SIZE / 4; i < SIZE / 2; ++i) {
+            pool.Deallocate(datas[i]);
+        }
+
+        datas.erase(datas.begin() + SIZE / 4, datas.begin() + SIZE / 2);
+
+        DevAssert(pool.Trim() > 0, "");
+
+        for (size_t i = 0; i < SIZE / 4; ++i) {
+            datas.push_back(pool.Allocate<Data>());
+        }
+
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+
+            DevAssert(pData->name == "Data", "");
+            cnt += pData->cnt;
+        }
+
+        DevAssert(cnt == datas.size(), "");
+
+        for (Data* pData : datas) {
+            pool.Deallocate(pData);
+        }
+
+        pool.Trim();
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_BlockCache() {
+
+        KoPoolBlockCache cache{};
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.subPoolAllocator = cache.GetBlockAllocator();
+        opt.metadataAllocator = cache.GetBlockAllocator();
+
+        constexpr size_t POOLS_CNT = 64;
+        constexpr size_t POOL_SIZE = 100;
+
+        size_t cnt = 0;
+
+        // The second generation of pools takes the blocks released by the first one
+        for (size_t generation = 0; generation < 2; ++generation) {
+
+            std::vector<KoPoolIteratable> pools;
+            for (size_t i = 0; i < POOLS_CNT; ++i) {
+                pools.emplace_back(opt);
+            }
+
+            std::vector<Data*> datas;
+            for (KoPoolIteratable& pool : pools) {
+
+                for (size_t i = 0; i < POOL_SIZE; ++i) {
+                    datas.push_back(pool.Allocate<Data>());
+                }
+            }
+
+            for (const KoPoolIteratable& pool : pools) {
+
+                KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+                while (Data* pData = iterator.Next()) {
+                    cnt += pData->cnt;
+                }
+            }
+
+            for (size_t i = 0; i < datas.size(); ++i) {
+                pools[i / POOL_SIZE].Deallocate(datas[i]);
+            }
+        }
+
+        DevAssert(cnt == 2 * POOLS_CNT * POOL_SIZE, "");
+
+        const KoPoolBlockCache::Stats stats = cache.GetStats();
+        DevAssert(stats.numHits >= stats.numMisses, "");
+
+        // More keys than the table holds, the blocks of the keys which don't fit are freed
+        KoPoolBlockCache keysCache{};
+        for (size_t i = 1; i <= 512; ++i) {
+            keysCache.Deallocate(keysCache.Allocate(i * 16, 16), i * 16, 16);
+        }
+
+        DevAssert(keysCache.GetStats().numBlocksCached > 0 && keysCache.GetStats().numBlocksCached < 512, "");
+
+        printf("%zu %zu\n", static_cast<size_t>(stats.numHits), static_cast<size_t>(stats.numMisses));
+    }
+
+    void Test_InitialSubPoolSize() {
+
+        constexpr size_t INITIAL_SUB_POOL_SIZE = 4096;
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.initialSubPoolSize = INITIAL_SUB_POOL_SIZE;
+        opt.growthFactor = 4;
+        opt.maxSubPoolSize = 1 << 16;
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<Data*> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            DevAssert(alloc.pMemory, "");
+
+            // A small pool is a single sub pool
+            DevAssert(i >= INITIAL_SUB_POOL_SIZE || alloc.subPoolID == 0, "");
+            DevAssert(pool.GetSubPoolCapacity(alloc.subPoolID) <= opt.maxSubPoolSize, "");
+
+            const KoPoolIteratable::USize id = pool.PtrToID(alloc.pMemory, alloc.subPoolID);
+            DevAssert(pool.IDToPtr(id) == alloc.pMemory, "");
+            DevAssert(pool.IDToSubPoolID(id) == alloc.subPoolID, "");
+
+            datas.push_back(new (alloc.pMemory) Data{});
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        const size_t numToRemove = _distribution(_rng);
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            pool.Deallocate(datas.back());
+            datas.pop_back();
+        }
+
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+            cnt += pData->cnt;
+        }
+
+        DevAssert(cnt == datas.size(), "");
+
+        for (Data* pData : datas) {
+            pool.Deallocate(pData);
+        }
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_ColocatedSkipBitmap() {
+
+        // Counts the metadata blocks, only 'SubPools' is allocated by the metadata allocator
+        size_t numMetadataBlocks = 0;
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.isSkipBitmapColocated = true;
+
+        using USize = KoPoolIteratable::USize;
+
+        opt.metadataAllocator.pUserData = &numMetadataBlocks;
+        opt.metadataAllocator.pAllocate = [](void* pUserData, USize sizeInBytes, USize alignment, USize) noexcept -> void* {
+
+            *reinterpret_cast<size_t*>(pUserData) += 1;
+            return ::operator new(sizeInBytes, std::align_val_t{ alignment }, std::nothrow);
+        };
+
+        opt.metadataAllocator.pDeallocate = [](void* pUserData, void* pMemory, USize, USize alignment, USize) noexcept {
+
+            *reinterpret_cast<size_t*>(pUserData) -= 1;
+            ::operator delete(pMemory, std::align_val_t{ alignment });
+        };
+
+        {
+            KoPoolIteratable pool{ opt };
+
+            std::vector<Data*> datas;
+            for (size_t i = 0; i < SIZE; ++i) {
+
+                const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+                DevAssert(alloc.pMemory, "");
+                DevAssert(reinterpret_cast<uintptr_t>(alloc.pMemory) % alignof(Data) == 0, "");
+
+                datas.push_back(new (alloc.pMemory) Data{});
+            }
+
+            DevAssert(numMetadataBlocks == 1, "");
+
+            std::shuffle(datas.begin(), datas.end(), _rng);
+
+            const size_t numToRemove = _distribution(_rng);
+            for (size_t i = 0; i < numToRemove; ++i) {
+
+                pool.Deallocate(datas.back());
+                datas.pop_back();
+            }
+
+            size_t cnt = 0;
+
+            KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+            while (Data* pData = iterator.Next()) {
+                cnt += pData->cnt;
+            }
+
+            DevAssert(cnt == datas.size(), "");
+
+            const KoPoolIteratable::Stats stats = pool.GetStats();
+            DevAssert(stats.numUsed == datas.size(), "");
+
+            for (Data* pData : datas) {
+                pool.Deallocate(pData);
+            }
+
+            DevAssert(pool.IsEmpty(), "");
+
+            printf("%zu\n", cnt);
+        }
+
+        DevAssert(numMetadataBlocks == 0, "");
+    }
+
+    // 8 bytes with '__KO_POOL_ITERATABLE_COMPACT_SKIP_NODES__', otherwise 16 bytes
+    void Test_MinElementSize() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = KoPoolIteratable::MIN_ELEMENT_SIZE_IN_BYTES;
+        opt.elementAlignment = alignof(uint32_t);
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<uint32_t*> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            DevAssert(alloc.pMemory, "");
+
+            const KoPoolIteratable::USize id = pool.PtrToID(alloc.pMemory, alloc.subPoolID);
+            DevAssert(pool.IDToPtr(id) == alloc.pMemory, "");
+
+            uint32_t* pData = reinterpret_cast<uint32_t*>(alloc.pMemory);
+            pData[0] = 1;
+
+            datas.push_back(pData);
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        const size_t numToRemove = _distribution(_rng);
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            pool.DeallocateBytesByPtr(datas.back());
+            datas.pop_back();
+        }
+
+        size_t cnt = 0;
+
+        KoPoolIterator<void> iterator = pool.GetIterator<void>();
+        while (const void* pData = iterator.Next()) {
+            cnt += *reinterpret_cast<const uint32_t*>(pData);
+        }
+
+        DevAssert(cnt == datas.size(), "");
+
+        for (uint32_t* pData : datas) {
+            pool.DeallocateBytesByPtr(pData);
+        }
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    // Many sub pools of the same size, the sorted pointers and their sub pool IDs must stay in sync
+    void Test_FindSubPoolIDByPtr() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.maxSubPoolSize = 1 << 8;
+
+        KoPoolIteratable pool{ opt };
+
+        // 8 sub pools up to the cap, then all but 2 of the remaining ones, so any '__KO_POOL_ITERATABLE_SUBPOOLS_CNT__' fits
+        const size_t numElements = std::min<size_t>(
+            SIZE, static_cast<size_t>(opt.maxSubPoolSize) * (KoPoolIteratable::SUBPOOLS_CNT - 8 - 2)
+        );
+
+        std::vector<Data*> datas;
+        for (size_t i = 0; i < numElements; ++i) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            DevAssert(alloc.pMemory, "");
+            DevAssert(pool.FindSubPoolIDByPtr(alloc.pMemory) == alloc.subPoolID, "");
+
+            datas.push_back(new (alloc.pMemory) Data{});
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        // Released sub pools are removed from the sorted pointers, refilled ones are inserted again
+        const size_t numToRemove = std::min<size_t>(_distribution(_rng), datas.size());
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            pool.Deallocate(datas.back());
+            datas.pop_back();
+        }
+
+        for (Data* pData : datas) {
+            DevAssert(pool.IDToPtr(pool.PtrToID(pData, pool.FindSubPoolIDByPtr(pData))) == reinterpret_cast<uint8_t*>(pData), "");
+        }
+
+        while (datas.size() < numElements) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            DevAssert(alloc.pMemory, "");
+            DevAssert(pool.FindSubPoolIDByPtr(alloc.pMemory) == alloc.subPoolID, "");
+
+            datas.push_back(new (alloc.pMemory) Data{});
+        }
+
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+            cnt += pData->cnt;
+        }
+
+        DevAssert(cnt == datas.size(), "");
+
+        for (Data* pData : datas) {
+            pool.Deallocate(pData);
+        }
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_NextEx() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+
+        KoPoolIteratable pool{ opt };
+
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+            DevAssert(alloc.pMemory, "");
+            DevAssert(alloc.id == pool.PtrToID(alloc.pMemory, alloc.subPoolID), "");
+
+            new (alloc.pMemory) Data{};
+        }
+
+        // Deallocate a random part while iterating, by the sub pool ID or by the ID, no searches
+        const size_t numToRemove = _distribution(_rng);
+        size_t numRemoved = 0;
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        for (KoPoolIterator<Data>::NextExResult next = iterator.NextEx(); next.pData; next = iterator.NextEx()) {
+
+            DevAssert(pool.IDToPtr(next.id) == reinterpret_cast<uint8_t*>(next.pData), "");
+            DevAssert(pool.IDToSubPoolID(next.id) == next.subPoolID, "");
+
+            cnt += next.pData->cnt;
+
+            if (numRemoved < numToRemove && _rng() % 2 == 0) {
+
+                if (numRemoved % 2 == 0) {
+                    pool.DeallocateBySubPoolID(next.pData, next.subPoolID);
+                }
+                else {
+                    pool.DeallocateByID<Data>(next.id);
+                }
+
+                iterator = iterator.GetFixedIteratorAfterDeallocate(next.pData);
+                numRemoved += 1;
+            }
+        }
+
+        DevAssert(cnt == SIZE, "");
+        DevAssert(pool.Size() == SIZE - numRemoved, "");
+
+        cnt = 0;
+
+        iterator = pool.GetIterator<Data>();
+        for (KoPoolIterator<Data>::NextExResult next = iterator.NextEx(); next.pData; next = iterator.NextEx()) {
+
+            cnt += next.pData->cnt;
+
+            pool.DeallocateBySubPoolID(next.pData, next.subPoolID);
+            iterator = iterator.GetFixedIteratorAfterDeallocate(next.pData);
+        }
+
+        DevAssert(cnt == SIZE - numRemoved, "");
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_UniquePtr() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<KoPoolUniquePtr<Data>> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            KoPoolUniquePtr<Data> pData = KoPoolMakeUnique<Data>(pool);
+            DevAssert(pData, "");
+            DevAssert(pData.GetSubPoolID() == pool.FindSubPoolIDByPtr(pData.Get()), "");
+
+            datas.push_back(std::move(pData));
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        const size_t numToRemove = _distribution(_rng);
+        datas.resize(SIZE - numToRemove);
+
+        DevAssert(pool.Size() == datas.size(), "");
+
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+
+            DevAssert(pData->name == "Data", "");
+            cnt += pData->cnt;
+        }
+
+        DevAssert(cnt == datas.size(), "");
+
+        // Released elements are owned by the caller
+        if (!datas.empty()) {
+
+            const KoPoolIteratable::USize subPoolID = datas.back().GetSubPoolID();
+            pool.DeallocateBySubPoolID(datas.back().Release(), subPoolID);
+        }
+
+        datas.clear();
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    struct RefData : KoPoolRefCounted {
+
+        RefData(const size_t value) noexcept
+            : value(value)
+        {}
+
+        size_t value = 0;
+        std::string name = "RefData";
+    };
+
+    void Test_RefPtr() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(RefData);
+        opt.elementAlignment = alignof(RefData);
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<KoPoolRefPtr<RefData>> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+
+            KoPoolRefPtr<RefData> pData = KoPoolMakeRef<RefData>(pool, i);
+            DevAssert(pData && pData->GetNumRefs() == 1, "");
+
+            datas.push_back(std::move(pData));
+        }
+
+        // Shared references, an element is freed with its last reference
+        const size_t numShared = _distribution(_rng);
+        for (size_t i = 0; i < numShared; ++i) {
+            datas.push_back(datas[_rng() % SIZE]);
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        datas.resize(datas.size() / 2);
+
+        size_t numRefs = 0;
+
+        KoPoolIterator<RefData> iterator = pool.GetIterator<RefData>();
+        while (RefData* pData = iterator.Next()) {
+
+            DevAssert(pData->name == "RefData" && pData->GetNumRefs() > 0, "");
+            numRefs += pData->GetNumRefs();
+        }
+
+        DevAssert(numRefs == datas.size(), "");
+
+        datas.clear();
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", numRefs);
+    }
+
+    void Test_DeallocateLater() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+
+        KoPoolIteratable pool{ opt };
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            DevAssert(pool.Allocate<Data>(), "");
+        }
+
+        // The iterator isn't fixed, the queued elements are freed after the iteration
+        size_t cnt = 0;
+        size_t numQueued = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+
+            cnt += pData->cnt;
+
+            if (_rng() % 3 == 0) {
+
+                pool.DeallocateLater(pData);
+                numQueued += 1;
+            }
+        }
+
+        DevAssert(cnt == SIZE, "");
+        DevAssert(pool.Size() == SIZE, "");
+        DevAssert(pool.GetNumDeferred() == numQueued, "");
+
+        DevAssert(pool.FlushDeferred() == numQueued, "");
+        DevAssert(pool.GetNumDeferred() == 0, "");
+        DevAssert(pool.Size() == SIZE - numQueued, "");
+
+        cnt = 0;
+
+        iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+
+            DevAssert(pData->name == "Data", "");
+            cnt += pData->cnt;
+
+            pool.DeallocateLater(pData);
+        }
+
+        DevAssert(cnt == SIZE - numQueued, "");
+
+        pool.FlushDeferred();
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_DeallocateRange() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+        opt.maxSubPoolSize = 1 << 12;
+
+        KoPoolIteratable pool{ opt };
+
+        // 12 sub pools up to the cap, then all but 2 of the remaining ones, so any '__KO_POOL_ITERATABLE_SUBPOOLS_CNT__' fits
+        const size_t numElements = std::min<size_t>(
+            SIZE, static_cast<size_t>(opt.maxSubPoolSize) * (KoPoolIteratable::SUBPOOLS_CNT - 12 - 2)
+        );
+
+        // IDs of a new pool are dense
+        for (size_t i = 0; i < numElements; ++i) {
+            DevAssert(pool.AllocateBytes().id == i, "");
+            new (pool.IDToPtr(i)) Data{};
+        }
+
+        // Random batches, which can span sub pools, every other one is deallocated
+        std::vector<std::pair<size_t, size_t>> batches;
+        for (size_t firstID = 0; firstID < numElements;) {
+
+            const size_t lastID = std::min<size_t>(firstID + _rng() % 10'000, numElements - 1);
+            batches.emplace_back(firstID, lastID);
+
+            firstID = lastID + 1;
+        }
+
+        std::shuffle(batches.begin(), batches.end(), _rng);
+
+        size_t numLive = numElements;
+        for (size_t i = 0; i < batches.size(); i += 2) {
+
+            pool.DeallocateRange<Data>(batches[i].first, batches[i].second);
+            numLive -= batches[i].second - batches[i].first + 1;
+        }
+
+        DevAssert(pool.Size() == numLive, "");
+
+        size_t cnt = 0;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        while (Data* pData = iterator.Next()) {
+
+            DevAssert(pData->name == "Data", "");
+            cnt += pData->cnt;
+        }
+
+        DevAssert(cnt == numLive, "");
+
+        for (size_t i = 1; i < batches.size(); i += 2) {
+            pool.DeallocateRange<Data>(batches[i].first, batches[i].second);
+        }
+
+        DevAssert(pool.IsEmpty(), "");
+
+        printf("%zu\n", cnt);
+    }
+
+    struct ClearData {
+
+        ~ClearData() noexcept {
+            *pNumDestroyed += 1;
+        }
+
+        size_t* pNumDestroyed = nullptr;
+        size_t cnt = 1;
+    };
+
+    void Test_Clear() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(ClearData);
+        opt.elementAlignment = alignof(ClearData);
+
+        KoPoolIteratable pool{ opt };
+
+        size_t numDestroyed = 0;
+        size_t cnt = 0;
+
+        // Frames: fill, free a part, clear, the sub pools of the first frame are reused
+        KoPoolIteratable::USize capacity = 0;
+        KoPoolIteratable::USize bytesReserved = 0;
+
+        for (size_t frame = 0; frame < 4; ++frame) {
+
+            std::vector<ClearData*> datas;
+            for (size_t i = 0; i < SIZE; ++i) {
+                datas.push_back(pool.Allocate<ClearData>(ClearData{ &numDestroyed }));
+            }
+
+            // The temporaries of 'Allocate(...)'
+            numDestroyed = 0;
+
+            if (frame == 0) {
+
+                capacity = pool.Capacity();
+                bytesReserved = pool.BytesReserved();
+            }
+
+            DevAssert(pool.Capacity() == capacity && pool.BytesReserved() == bytesReserved, "");
+
+            std::shuffle(datas.begin(), datas.end(), _rng);
+
+            const size_t numToRemove = _distribution(_rng);
+            for (size_t i = 0; i < numToRemove; ++i) {
+
+                pool.Deallocate(datas.back());
+                datas.pop_back();
+            }
+
+            cnt = 0;
+
+            KoPoolIterator<ClearData> iterator = pool.GetIterator<ClearData>();
+            while (ClearData* pData = iterator.Next()) {
+                cnt += pData->cnt;
+            }
+
+            DevAssert(cnt == datas.size(), "");
+
+            pool.Clear<ClearData>();
+
+            DevAssert(numDestroyed == SIZE, "");
+            DevAssert(pool.IsEmpty() && pool.Size() == 0, "");
+            DevAssert(!pool.GetIterator<ClearData>().Next(), "");
+
+            numDestroyed = 0;
+        }
+
+        printf("%zu\n", cnt);
+    }
+
+    void Test_ElementDestructor() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(ClearData);
+        opt.elementAlignment = alignof(ClearData);
+        opt.elementDestructor = KoPoolIteratable::MakeElementDestructor<ClearData>();
+
+        size_t numDestroyed = 0;
+
+        const auto fill = [&](KoPoolIteratable& pool) {
+
+            std::vector<ClearData*> datas;
+            for (size_t i = 0; i < SIZE; ++i) {
+
+                ClearData* pData = reinterpret_cast<ClearData*>(pool.AllocateBytes().pMemory);
+                datas.push_back(new (pData) ClearData{ &numDestroyed });
+            }
+
+            std::shuffle(datas.begin(), datas.end(), _rng);
+
+            // The typed deallocations call the destructor themselves
+            const size_t numToRemove = _distribution(_rng);
+            for (size_t i = 0; i < numToRemove; ++i) {
+
+                pool.Deallocate(datas.back());
+                datas.pop_back();
+            }
+        };
+
+        {
+            KoPoolIteratable pool{ opt };
+
+            fill(pool);
+            pool.DeallocateBytesAll();
+            DevAssert(numDestroyed == SIZE, "");
+
+            fill(pool);
+            pool.Reset();
+            DevAssert(numDestroyed == 2 * SIZE && pool.IsEmpty(), "");
+
+            fill(pool);
+        }
+
+        // The remaining elements are destroyed by the pool destructor
+        DevAssert(numDestroyed == 3 * SIZE, "");
+
+        printf("%zu\n", numDestroyed);
+    }
+
+    void Test_RankIndex() {
+
+        KoPoolIteratable::Opt opt{};
+        opt.elementSizeInBytes = sizeof(Data);
+        opt.elementAlignment = alignof(Data);
+
+        KoPoolIteratable pool{ opt };
+
+        std::vector<Data*> datas;
+        for (size_t i = 0; i < SIZE; ++i) {
+            datas.push_back(pool.Allocate<Data>());
+        }
+
+        std::shuffle(datas.begin(), datas.end(), _rng);
+
+        const size_t numToRemove = _distribution(_rng);
+        for (size_t i = 0; i < numToRemove; ++i) {
+
+            pool.Deallocate(datas.back());
+            datas.pop_back();
+        }
+
+        // The iteration is in ID order, so the dense ranks are the iteration order
+        std::vector<KoPoolIteratable::USize> ids;
+
+        KoPoolIterator<Data> iterator = pool.GetIterator<Data>();
+        for (KoPoolIterator<Data>::NextExResult next = iterator.NextEx(); next.pData; next = iterator.NextEx()) {
+            ids.push_back(next.id);
+        }
+
+        KoPoolRankIndex rankIndex{ pool };
+        DevAssert(rankIndex.Size() == ids.size(), "");
+
+        for (size_t rank = 0; rank < ids.size(); ++rank) {
+
+            DevAssert(rankIndex.NthLive(rank) == ids[rank], "");
+            DevAssert(rankIndex.RankOf(ids[rank]) == rank, "");
+        }
+
+        size_t cnt = 0;
+        for (size_t i = 0; i < ids.size() / 16; ++i) {
+
+            const KoPoolIteratable::USize id = rankIndex.SampleUniform(_rng);
+            cnt += reinterpret_cast<Data*>(pool.IDToPtr(id))->cnt;
+        }
+
+        DevAssert(cnt == ids.size() / 16, "");
+
+        // Stale after the pool changes, the next query rebuilds the directory
+        const KoPoolIteratable::AllocBytesResult alloc = pool.AllocateBytes();
+        DevAssert(rankIndex.IsStale(), "");
+        DevAssert(rankIndex.NthLive(rankIndex.RankOf(alloc.id)) == alloc.id, "");
+        DevAssert(!rankIndex.IsStale() && rankIndex.Size() == ids.size() + 1, "");
+
+        // The same size and sub pools, only 'Invalidate()' makes it stale
+        pool.DeallocateBytesByID(alloc.id);
+        const KoPoolIteratable::AllocBytesResult realloc = pool.AllocateBytes();
+        rankIndex.Invalidate();
+        DevAssert(rankIndex.IsStale(), "");
+        DevAssert(rankIndex.NthLive(rankIndex.RankOf(realloc.id)) == realloc.id, "");
+
+        pool.DeallocateBytesByID(realloc.id);
+        for (Data* pData : datas) {
+            pool.Deallocate(pData);
+        }
+
+        DevAssert(rankIndex.IsStale(), "");
+        DevAssert(rankIndex.IsEmpty(), "");
+        DevAssert(rankIndex.SampleUniform(_rng) == KoPoolRankIndex::ID_NONE, "");
+
+        printf("%zu\n", ids.size());
+    }
 
 private:
 